@@ -0,0 +1,188 @@
+#include "BattInfo.h"
+
+#include <array>
+
+namespace {
+constexpr qsizetype maxLines = 12; // the tester sends 7
+constexpr qsizetype normPosition = 2; // lines with a value come as SOH, SOC, norm, rated value, resistance and voltage
+
+// ISO-8859-15 differs from ISO-8859-1 only in eight characters.
+constexpr std::array<char16_t, 256> generateLatin9Table() {
+  std::array<char16_t, 256> table{};
+  for (int i = 0; i < 256; i++)
+    table[i] = static_cast<char16_t>(i);
+  table[0x7F] = u'\u03A9'; // not a part of the code page, the tester sends it as the ohm sign
+  table[0xA4] = u'\u20AC';
+  table[0xA6] = u'\u0160';
+  table[0xA8] = u'\u0161';
+  table[0xB4] = u'\u017D';
+  table[0xB8] = u'\u017E';
+  table[0xBC] = u'\u0152';
+  table[0xBD] = u'\u0153';
+  table[0xBE] = u'\u0178';
+  return table;
+}
+
+constexpr std::array<char16_t, 256> latin9Table = generateLatin9Table();
+
+enum class Field : uchar { Unknown, Soh, Soc, Norm, Rated, Resistance, Voltage };
+
+// Keys used by the tester, upper case and in ISO-8859-15. Norm names aren't translated, the rest covers the languages of the tester menu,
+// values of the lines that aren't found here are recognised by their format, the norm by its position.
+struct Key {
+  const char* text;
+  Field field;
+};
+
+constexpr Key keys[] = {
+    {"SOH", Field::Soh},           {"SOC", Field::Soc},          {"EN", Field::Norm},          {"SAE", Field::Norm},
+    {"DIN", Field::Norm},          {"IEC", Field::Norm},         {"JIS", Field::Norm},         {"CA", Field::Norm},
+    {"MCA", Field::Norm},          {"BCI", Field::Norm},         {"GB", Field::Norm},          {"CCA", Field::Norm},         {"RATED", Field::Rated},
+    {"NENN", Field::Rated},        {"NOMINAL", Field::Rated},    {"NOMINALE", Field::Rated},   {"R", Field::Resistance},
+    {"IR", Field::Resistance},     {"RI", Field::Resistance},    {"VOLTAGE", Field::Voltage},  {"SPANNUNG", Field::Voltage},
+    {"TENSION", Field::Voltage},   {"TENSIONE", Field::Voltage}, {"TENSI\xD3N", Field::Voltage}, {"TENS\xC3O", Field::Voltage},
+    {"VOLTAJE", Field::Voltage},   {"SPANNING", Field::Voltage},
+};
+
+struct Span {
+  qsizetype pos = 0;
+  qsizetype len = -1; // negative when not found
+
+  bool isValid() const { return len >= 0; }
+};
+
+uchar upper(uchar c) { return (c >= 'a' && c <= 'z') || (c >= 0xE0 && c <= 0xFE && c != 0xF7) ? c - 0x20 : c; } // ASCII and Latin-9 letters
+
+Span trimmed(const RingBuffer::View& text, qsizetype pos, qsizetype end) {
+  while (pos < end && (text[pos] == ' ' || text[pos] == '\t'))
+    pos++;
+  while (end > pos && (text[end - 1] == ' ' || text[end - 1] == '\t'))
+    end--;
+  return Span{pos, end - pos};
+}
+
+Field fieldOfKey(const RingBuffer::View& text, const Span& key) {
+  for (const Key& k : keys) {
+    qsizetype i = 0;
+    while (i < key.len && k.text[i] && upper(text[key.pos + i]) == static_cast<uchar>(k.text[i]))
+      i++;
+    if (i == key.len && !k.text[i])
+      return k.field;
+  }
+  return Field::Unknown;
+}
+
+bool endsWith(const RingBuffer::View& text, const Span& value, char c) { return value.len > 0 && text[value.pos + value.len - 1] == static_cast<uchar>(c); }
+
+bool contains(const RingBuffer::View& text, const Span& value, uchar c) {
+  for (qsizetype i = 0; i < value.len; i++)
+    if (text[value.pos + i] == c)
+      return true;
+  return false;
+}
+
+int leadingNumber(const RingBuffer::View& text, const Span& value) {
+  int res = 0;
+  for (qsizetype i = 0; i < value.len && text[value.pos + i] >= '0' && text[value.pos + i] <= '9' && res < 100000; i++)
+    res = res * 10 + (text[value.pos + i] - '0');
+  return res;
+}
+
+// Stores the decoded text in str, without allocating when str already has enough unshared memory.
+void assignLatin9(QString& str, const RingBuffer::View& text, const Span& first, const Span& second = Span{0, 0}, char16_t separator = 0) {
+  const qsizetype len = first.len + (separator ? 1 : 0) + second.len;
+  str.resize(len);
+  char16_t* out = reinterpret_cast<char16_t*>(str.data());
+  for (qsizetype i = 0; i < first.len; i++)
+    *out++ = latin9Table[text[first.pos + i]];
+  if (separator)
+    *out++ = separator;
+  for (qsizetype i = 0; i < second.len; i++)
+    *out++ = latin9Table[text[second.pos + i]];
+}
+} // namespace
+
+bool BattInfo::parse(const RingBuffer::View& text, BattInfo& info) {
+  Span keySpans[maxLines], valueSpans[maxLines];
+  Field fields[maxLines];
+  Span conditionSpan;
+  qsizetype lines = 0;
+
+  // split into lines and then into a key and a value, lines without '=' hold the overall condition
+  const qsizetype textLen = text.length();
+  for (qsizetype lineStart = 0; lineStart < textLen && lines < maxLines;) {
+    qsizetype lineEnd = lineStart, separator = -1;
+    while (lineEnd < textLen && text[lineEnd] != '\n') {
+      if (separator < 0 && text[lineEnd] == '=')
+        separator = lineEnd;
+      lineEnd++;
+    }
+    const qsizetype next = lineEnd + 1;
+    if (lineEnd > lineStart && text[lineEnd - 1] == '\r')
+      lineEnd--;
+
+    if (separator < 0) {
+      const Span line = trimmed(text, lineStart, lineEnd);
+      if (line.len > 0)
+        conditionSpan = line;
+    } else {
+      keySpans[lines] = trimmed(text, lineStart, separator);
+      valueSpans[lines] = trimmed(text, separator + 1, lineEnd);
+      fields[lines] = fieldOfKey(text, keySpans[lines]);
+      lines++;
+    }
+    lineStart = next;
+  }
+
+  // a norm that isn't known is the line before the rated value, or the line where the tester sends the norm
+  bool normFound = false;
+  for (qsizetype i = 0; i < lines; i++)
+    normFound = normFound || fields[i] == Field::Norm;
+  for (qsizetype i = 1; i < lines && !normFound; i++)
+    if (fields[i] == Field::Rated && fields[i - 1] == Field::Unknown) {
+      fields[i - 1] = Field::Norm;
+      normFound = true;
+    }
+  if (!normFound && normPosition < lines && fields[normPosition] == Field::Unknown)
+    fields[normPosition] = Field::Norm;
+
+  // lines with unknown keys: percentages are SOH and then SOC, the omega sign marks the resistance, the rated value follows the norm,
+  // and the voltage is in volts
+  Span found[7];
+  for (qsizetype i = 0; i < lines; i++) {
+    Field field = fields[i];
+    if (field == Field::Unknown) {
+      if (endsWith(text, valueSpans[i], '%'))
+        field = found[int(Field::Soh)].isValid() ? Field::Soc : Field::Soh;
+      else if (contains(text, valueSpans[i], 0x7F))
+        field = Field::Resistance;
+      else if (i > 0 && fields[i - 1] == Field::Norm && !found[int(Field::Rated)].isValid())
+        field = Field::Rated;
+      else if (endsWith(text, valueSpans[i], 'V') || endsWith(text, valueSpans[i], 'v'))
+        field = Field::Voltage;
+      fields[i] = field;
+    }
+    if (field != Field::Unknown && !found[int(field)].isValid())
+      found[int(field)] = (field == Field::Norm) ? Span{i, 0} : valueSpans[i]; // for the norm both the key and the value are needed
+  }
+
+  for (int f = int(Field::Soh); f <= int(Field::Voltage); f++)
+    if (!found[f].isValid())
+      return false;
+  if (!conditionSpan.isValid())
+    return false;
+
+  const qsizetype normLine = found[int(Field::Norm)].pos;
+  info.soh = leadingNumber(text, found[int(Field::Soh)]);
+  info.soc = leadingNumber(text, found[int(Field::Soc)]);
+  assignLatin9(info.testNorm, text, keySpans[normLine], found[int(Field::Rated)], u'-');
+  assignLatin9(info.testResult, text, valueSpans[normLine]);
+  assignLatin9(info.resistance, text, found[int(Field::Resistance)]);
+  assignLatin9(info.voltage, text, found[int(Field::Voltage)]);
+  assignLatin9(info.condition, text, conditionSpan);
+  return true;
+}
+
+bool BattInfo::parse(const QByteArray& text, BattInfo& info) {
+  return parse(RingBuffer::View{{reinterpret_cast<const uchar*>(text.constData()), text.size()}, {}}, info);
+}
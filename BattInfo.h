@@ -0,0 +1,27 @@
+#ifndef BATTINFO_H
+#define BATTINFO_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "RingBuffer.h"
+
+// Battery parameters from the text of a type 1 packet. The text is in the language selected in the tester, encoded in ISO-8859-15
+// (the code page field of the packet never changes), with lines separated by CR LF.
+struct BattInfo {
+  int soh = 0;        // state of health in %
+  int soc = 0;        // state of charge in %
+  QString testNorm;   // norm and its rated value, e.g. EN-600CCA
+  QString testResult; // measured value in units of the norm
+  QString resistance; // internal resistance with the omega sign
+  QString voltage;
+  QString condition;
+
+  // Values are identified by their keys, for languages with unknown keys by the format of the value, so the order of the lines doesn't matter.
+  // The text is scanned in place without allocating anything, only the strings stored in info may allocate, and they reuse their memory
+  // when they aren't shared. Returns false if any value is missing, info is left unchanged then.
+  static bool parse(const RingBuffer::View& text, BattInfo& info);
+  static bool parse(const QByteArray& text, BattInfo& info);
+};
+
+#endif // BATTINFO_H
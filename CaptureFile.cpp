@@ -0,0 +1,88 @@
+#include "CaptureFile.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+bool CaptureWriter::open(const QString& fileName) {
+  close();
+  file.setFileName(fileName);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    return false;
+
+  uchar header[CaptureFormat::headerSize] = {};
+  memcpy(header, CaptureFormat::magic, sizeof(CaptureFormat::magic));
+  qToLittleEndian<quint32>(CaptureFormat::version, header + 8);
+  qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 16);
+  clock.start();
+  return file.write(reinterpret_cast<const char*>(header), sizeof(header)) == sizeof(header);
+}
+
+bool CaptureWriter::writeChunk(const RingBuffer::View& data) {
+  if (!file.isOpen() || data.isEmpty())
+    return false;
+
+  uchar chunkHeader[CaptureFormat::chunkHeaderSize];
+  qToLittleEndian<quint64>(clock.nsecsElapsed(), chunkHeader);
+  qToLittleEndian<quint32>(data.length(), chunkHeader + 8);
+
+  bool res = file.write(reinterpret_cast<const char*>(chunkHeader), sizeof(chunkHeader)) == sizeof(chunkHeader);
+  res &= file.write(reinterpret_cast<const char*>(data.first().data), data.first().length) == data.first().length;
+  if (data.second().length)
+    res &= file.write(reinterpret_cast<const char*>(data.second().data), data.second().length) == data.second().length;
+  return res;
+}
+
+void CaptureWriter::close() {
+  if (file.isOpen())
+    file.close();
+}
+
+bool CaptureReader::open(const QString& fileName) {
+  close();
+  file.setFileName(fileName);
+  if (!file.open(QFile::ReadOnly)) {
+    error = file.errorString();
+    return false;
+  }
+
+  size = file.size();
+  if (size < CaptureFormat::headerSize || !(mapped = file.map(0, size))) {
+    error = size < CaptureFormat::headerSize ? QStringLiteral("File is too short.") : file.errorString();
+    close();
+    return false;
+  }
+
+  if (memcmp(mapped, CaptureFormat::magic, sizeof(CaptureFormat::magic)) || qFromLittleEndian<quint32>(mapped + 8) != CaptureFormat::version) {
+    error = QStringLiteral("Unsupported file format.");
+    close();
+    return false;
+  }
+
+  startMs = qFromLittleEndian<qint64>(mapped + 16);
+  pos = CaptureFormat::headerSize;
+  return true;
+}
+
+bool CaptureReader::readChunk(Chunk& chunk) {
+  if (mapped == nullptr || size - pos < CaptureFormat::chunkHeaderSize)
+    return false;
+
+  const qsizetype length = qFromLittleEndian<quint32>(mapped + pos + 8);
+  if (size - pos - CaptureFormat::chunkHeaderSize < length)
+    return false; // capture was interrupted while writing the last chunk
+
+  chunk.timestampNs = qFromLittleEndian<quint64>(mapped + pos);
+  chunk.data = mapped + pos + CaptureFormat::chunkHeaderSize;
+  chunk.length = length;
+  pos += CaptureFormat::chunkHeaderSize + length;
+  return true;
+}
+
+void CaptureReader::close() {
+  if (mapped != nullptr)
+    file.unmap(const_cast<uchar*>(mapped));
+  mapped = nullptr;
+  if (file.isOpen())
+    file.close();
+  size = pos = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include "RingBuffer.h"
+
+// Capture files hold every chunk of raw data received from the serial port, so a session can be decoded again later.
+// Format (little-endian): 8 byte magic, quint32 version, quint32 reserved, qint64 capture start (ms since epoch),
+// then chunks, each one made of quint64 time since the capture start (ns, monotonic), quint32 data length and the data itself.
+namespace CaptureFormat {
+constexpr char magic[8] = {'K', 'B', 'T', 'C', 'A', 'P', '\r', '\n'};
+constexpr quint32 version = 1;
+constexpr qsizetype headerSize = 24;
+constexpr qsizetype chunkHeaderSize = 12;
+} // namespace CaptureFormat
+
+// Appends received data to a capture file. Data is written through QFile's buffer, so a chunk doesn't cost a system call.
+class CaptureWriter {
+public:
+  CaptureWriter() = default;
+  ~CaptureWriter() { close(); }
+
+  bool open(const QString& fileName);
+  bool isOpen() const { return file.isOpen(); }
+  bool writeChunk(const RingBuffer::View& data);
+  void close();
+  QString errorString() const { return file.errorString(); }
+
+private:
+  QFile file;
+  QElapsedTimer clock;
+};
+
+// Reads a capture file through a memory mapping, chunks point directly into the mapped file.
+class CaptureReader {
+public:
+  struct Chunk {
+    quint64 timestampNs = 0; // time since the capture start
+    const uchar* data = nullptr;
+    qsizetype length = 0;
+  };
+
+public:
+  CaptureReader() = default;
+  ~CaptureReader() { close(); }
+
+  bool open(const QString& fileName);
+  bool readChunk(Chunk& chunk); // returns false at the end of the file or if the rest of the file is damaged
+  bool atEnd() const { return pos >= size; }
+  void rewind() { pos = CaptureFormat::headerSize; }
+  void close();
+
+  qint64 captureStartMs() const { return startMs; }
+  QString errorString() const { return error; }
+
+private:
+  QFile file;
+  const uchar* mapped = nullptr;
+  qsizetype size = 0;
+  qsizetype pos = 0;
+  qint64 startMs = 0;
+  QString error;
+};
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,18 @@
+#ifndef DECODEDFRAME_H
+#define DECODEDFRAME_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Packet decoded by the serial port worker, owns its data so it can be safely passed to the UI thread.
+struct DecodedFrame {
+  enum class Type : uchar { None, BattInfo, Chart, ChartDisplay };
+
+  Type type = Type::None;
+  QByteArray text;         // battery info text, without header, code page and trailer
+  QVector<ushort> samples; // raw voltage samples of a chart packet, in 0.1 V units
+  qint64 receivedNs = 0;   // PipelineMetrics::now() when the last part of the packet was received
+  quint32 traceId = 0;     // links decoding and displaying of the frame in the trace, 0 when not tracing
+};
+
+#endif // DECODEDFRAME_H
@@ -0,0 +1,99 @@
+#include "DeviceSession.h"
+
+#include "Trace.h"
+
+DeviceSession::DeviceSession(const QString& name, QThread* workerThread, QObject* parent) : QObject{parent}, sessionName(name) {
+  receivedWaveform.reserve(waveformReservedSamples);
+  displayedWaveform.reserve(waveformReservedSamples);
+
+  serialWorker = new SerialWorker(frameQueue, pipelineMetrics);
+  serialWorker->moveToThread(workerThread);
+  connect(serialWorker, &SerialWorker::framesAvailable, this, &DeviceSession::onFramesAvailable);
+  connect(serialWorker, &SerialWorker::serialPortOpened, this, [this](bool success) {
+    active = success;
+    emit opened(success);
+  });
+  connect(serialWorker, &SerialWorker::serialPortError, this, &DeviceSession::errorOccurred);
+  connect(serialWorker, &SerialWorker::captureError, this, &DeviceSession::captureError);
+  connect(serialWorker, &SerialWorker::replayStarted, this, [this](bool success, const QString& errorString) {
+    active = success;
+    emit replayStarted(success, errorString);
+  });
+  connect(serialWorker, &SerialWorker::replayFinished, this, [this]() {
+    active = false;
+    emit replayFinished();
+  });
+  connect(serialWorker, &SerialWorker::firmwareUpdateProgress, this, &DeviceSession::firmwareUpdateProgress);
+  connect(serialWorker, &SerialWorker::firmwareUpdateFinished, this, &DeviceSession::firmwareUpdateFinished);
+}
+
+DeviceSession::~DeviceSession() {
+  // the worker uses our frame queue, so it must be gone before we are
+  SerialWorker* worker = serialWorker;
+  if (worker->thread()->isRunning())
+    QMetaObject::invokeMethod(worker, [worker]() { delete worker; }, Qt::BlockingQueuedConnection);
+  else
+    delete worker;
+}
+
+void DeviceSession::open(const QString& captureFileName) {
+  replaying = false;
+  SerialWorker* worker = serialWorker;
+  const QString portName = sessionName;
+  QMetaObject::invokeMethod(worker, [worker, portName, captureFileName]() { worker->openSerialPort(portName, captureFileName); });
+}
+
+void DeviceSession::replay(const QString& fileName, bool realTime) {
+  replaying = true;
+  SerialWorker* worker = serialWorker;
+  QMetaObject::invokeMethod(worker, [worker, fileName, realTime]() { worker->replayCapture(fileName, realTime); });
+}
+
+void DeviceSession::close() {
+  active = false;
+  QMetaObject::invokeMethod(serialWorker, &SerialWorker::closeSerialPort);
+}
+
+void DeviceSession::updateFirmware(const QString& imageFileName) {
+  SerialWorker* worker = serialWorker;
+  QMetaObject::invokeMethod(worker, [worker, imageFileName]() { worker->startFirmwareUpdate(imageFileName); });
+}
+
+void DeviceSession::cancelFirmwareUpdate() { QMetaObject::invokeMethod(serialWorker, &SerialWorker::cancelFirmwareUpdate); }
+
+void DeviceSession::onFramesAvailable() {
+  const Trace::Span span("DeviceSession::onFramesAvailable");
+  serialWorker->acknowledgeFrames(); // frames queued from now on will be announced with the next signal
+
+  DecodedFrame frame;
+  bool progress = false;
+  while (frameQueue.pop(frame)) {
+    pipelineMetrics.deliveryLatency.record(PipelineMetrics::now() - frame.receivedNs);
+    Trace::flowEnd("frame", frame.traceId);
+    switch (frame.type) {
+    case DecodedFrame::Type::BattInfo:
+      if (BattInfo::parse(frame.text, lastBattInfo)) {
+        battInfoValid = true;
+        emit battInfoReceived();
+      }
+      break;
+    case DecodedFrame::Type::Chart:
+      receivedWaveform.append(frame.samples); // packets of the same type are continuation of the current chart
+      progress = true;
+      break;
+    case DecodedFrame::Type::ChartDisplay:
+      if (receivedWaveform.isEmpty())
+        break; // nothing to display
+      std::swap(displayedWaveform, receivedWaveform); // buffers are reused by the next chart
+      receivedWaveform.clear();
+      progress = false; // the whole chart is published
+      displayedMetrics = WaveformAnalysis::analyze(displayedWaveform); // a fraction of a millisecond, so it's done right here
+      emit waveformReceived();
+      break;
+    case DecodedFrame::Type::None:
+      break;
+    }
+  }
+  if (progress)
+    emit waveformProgress();
+}
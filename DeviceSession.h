@@ -0,0 +1,72 @@
+#ifndef DEVICESESSION_H
+#define DEVICESESSION_H
+
+#include <QObject>
+#include <QThread>
+
+#include "BattInfo.h"
+#include "DecodedFrame.h"
+#include "PipelineMetrics.h"
+#include "SerialWorker.h"
+#include "SpscQueue.h"
+#include "Waveform.h"
+#include "WaveformAnalysis.h"
+
+// One tester: the worker that reads and decodes the data of its serial port (or replays a capture) and the results received from it.
+// The worker runs in a thread shared with other sessions, results are collected here, in the GUI thread.
+class DeviceSession : public QObject {
+  Q_OBJECT
+public:
+  DeviceSession(const QString& name, QThread* workerThread, QObject* parent = nullptr);
+  ~DeviceSession(); // waits until the worker closes the port
+
+public:
+  const QString& name() const { return sessionName; } // port name, or capture file name when replaying
+  bool isActive() const { return active; }            // port is open or a capture is being replayed
+  bool isReplay() const { return replaying; }         // results come from a capture file, not from a tester
+  void open(const QString& captureFileName = QString());
+  void replay(const QString& fileName, bool realTime);
+  void close();
+  void updateFirmware(const QString& imageFileName); // only when connected to a tester, see SerialWorker::startFirmwareUpdate()
+  void cancelFirmwareUpdate();
+
+  const Waveform& waveform() const { return displayedWaveform; } // the last complete chart
+  const Waveform& receivingWaveform() const { return receivedWaveform; } // chart being received, may be empty
+  const WaveformMetrics& waveformMetrics() const { return displayedMetrics; }
+  const BattInfo& battInfo() const { return lastBattInfo; }
+  bool hasBattInfo() const { return battInfoValid; }
+  PipelineMetrics& metrics() { return pipelineMetrics; } // updated by the worker thread too, read it through snapshots
+
+signals:
+  void opened(bool success);
+  void errorOccurred(const QSerialPort::SerialPortError& error);
+  void captureError(const QString& errorString);
+  void replayStarted(bool success, const QString& errorString);
+  void replayFinished();
+  void battInfoReceived();
+  void waveformReceived();
+  void waveformProgress(); // more samples of the chart being received, at most once for a batch of frames
+  void firmwareUpdateProgress(qint64 doneBytes, qint64 totalBytes);
+  void firmwareUpdateFinished(bool success, const QString& errorString);
+
+private slots:
+  void onFramesAvailable();
+
+private:
+  static constexpr qsizetype waveformReservedSamples = 2048; // enough for a 10 s cranking test, so the buffers don't grow during decoding
+
+  QString sessionName;
+  bool active = false;
+  bool replaying = false;
+  SpscQueue<DecodedFrame> frameQueue{1024}; // filled by the worker, emptied here
+  PipelineMetrics pipelineMetrics;
+  SerialWorker* serialWorker = nullptr;
+
+  Waveform receivedWaveform;  // chart being received, published at once when the tester asks to display it
+  Waveform displayedWaveform; // source of the chart, exports and analysis
+  WaveformMetrics displayedMetrics;
+  BattInfo lastBattInfo;
+  bool battInfoValid = false;
+};
+
+#endif // DEVICESESSION_H
@@ -0,0 +1,57 @@
+#include "Export.h"
+
+#include <charconv>
+
+namespace Export {
+namespace {
+constexpr qsizetype batchSize = 32 * 1024;
+constexpr qsizetype maxLineLength = 64; // two numbers in %g format and separators always fit
+
+// Same result as QTextStream with its default settings, which is %g with 6 significant digits.
+inline char* appendNumber(char* pos, char* end, double value) { return std::to_chars(pos, end, value, std::chars_format::general, 6).ptr; }
+} // namespace
+
+void writeStateTxt(QTextStream& data, const BattInfo& info, const StateLabels& labels) {
+  data << labels.soh << ' ' << info.soh << '%' << '\n';
+  data << labels.soc << ' ' << info.soc << '%' << '\n';
+  data << labels.resistance << ' ' << info.resistance << '\n';
+  data << labels.testNorm << ' ' << info.testNorm << '\n';
+  data << labels.testResult << ' ' << info.testResult << '\n';
+  data << labels.voltage << ' ' << info.voltage << '\n';
+  data << labels.condition << ' ' << info.condition << '\n';
+}
+
+void writeStateCsv(QTextStream& data, const BattInfo& info, const StateLabels& labels) {
+  data << labels.soh << ',' << labels.soc << ',' << labels.resistance << ',' << labels.testNorm << ',' << labels.testResult << ',' << labels.voltage << ',' << labels.condition << '\n';
+  data << info.soh << '%' << ',' << info.soc << '%' << ',' << info.resistance << ',' << info.testNorm << ',' << info.testResult << ',' << info.voltage << ',' << info.condition << '\n';
+}
+
+bool writeWaveformCsv(QIODevice& device, const Waveform& waveform, const WaveformLabels& labels, const ProgressCallback& progress) {
+  const QByteArray header = QString(labels.time + ',' + labels.voltage + '\n').toUtf8();
+  if (device.write(header) != header.size())
+    return false;
+
+  char batch[batchSize];
+  char* const end = batch + batchSize;
+  char* pos = batch;
+  const qsizetype total = waveform.size();
+  for (qsizetype i = 0; i < total; i++) {
+    pos = appendNumber(pos, end, waveform.timeAt(i));
+    *pos++ = ',';
+    pos = appendNumber(pos, end, waveform.voltageAt(i));
+    *pos++ = '\n';
+
+    if (end - pos < maxLineLength) {
+      if (device.write(batch, pos - batch) != pos - batch)
+        return false;
+      pos = batch;
+      if (progress && !progress(i + 1, total))
+        return false;
+    }
+  }
+
+  if (pos != batch && device.write(batch, pos - batch) != pos - batch)
+    return false;
+  return !progress || progress(total, total);
+}
+} // namespace Export
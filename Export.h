@@ -0,0 +1,40 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <QIODevice>
+#include <QTextStream>
+
+#include <functional>
+
+#include "BattInfo.h"
+#include "Waveform.h"
+
+// Text formats of the saved battery state and waveform, shared by the application and kbtinfo-cli.
+namespace Export {
+// Captions of the battery state values, the application passes the translated ones from its UI.
+struct StateLabels {
+  QString soh = QStringLiteral("SOH:");
+  QString soc = QStringLiteral("SOC:");
+  QString resistance = QStringLiteral("Internal resistance:");
+  QString testNorm = QStringLiteral("Test norm:");
+  QString testResult = QStringLiteral("Test result:");
+  QString voltage = QStringLiteral("Battery voltage:");
+  QString condition = QStringLiteral("Overall condition:");
+};
+
+struct WaveformLabels {
+  QString time = QStringLiteral("Time [s]");
+  QString voltage = QStringLiteral("Voltage [V]");
+};
+
+// Called between the written batches, returning false stops the export.
+using ProgressCallback = std::function<bool(qsizetype done, qsizetype total)>;
+
+void writeStateTxt(QTextStream& data, const BattInfo& info, const StateLabels& labels = StateLabels());
+void writeStateCsv(QTextStream& data, const BattInfo& info, const StateLabels& labels = StateLabels());
+// Numbers are formatted the same way as QTextStream does it, but straight into a buffer that is written in large batches.
+// Returns false if writing failed or the export was stopped.
+bool writeWaveformCsv(QIODevice& device, const Waveform& waveform, const WaveformLabels& labels = WaveformLabels(), const ProgressCallback& progress = nullptr);
+} // namespace Export
+
+#endif // EXPORT_H
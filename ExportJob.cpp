@@ -0,0 +1,41 @@
+#include "ExportJob.h"
+
+#include <QThreadPool>
+
+ExportJob::ExportJob(const QString& fileName, QIODevice::OpenMode mode, Writer writer, QObject* parent)
+    : QObject{parent}, outputName(fileName), openMode(mode), writer(std::move(writer)) {}
+
+void ExportJob::start() {
+  QThreadPool::globalInstance()->start([this] { run(); });
+}
+
+void ExportJob::cancel() { canceled.store(true, std::memory_order_relaxed); }
+
+void ExportJob::run() {
+  QSaveFile file(outputName);
+  if (!file.open(QIODevice::WriteOnly | openMode)) {
+    emit finished(false, file.errorString());
+    return;
+  }
+
+  const Export::ProgressCallback progress = [this](qsizetype done, qsizetype total) {
+    const int percent = total ? int(done * 100 / total) : 100;
+    if (percent != lastPercent) { // signals are queued to the GUI thread, so don't send one for every batch
+      lastPercent = percent;
+      emit progressChanged(percent);
+    }
+    return !canceled.load(std::memory_order_relaxed);
+  };
+
+  bool success = writer(file, progress) && !canceled.load(std::memory_order_relaxed);
+  QString errorString;
+  if (!success) {
+    if (!canceled.load(std::memory_order_relaxed))
+      errorString = file.error() != QFileDevice::NoError ? file.errorString() : tr("Unable to write the data.");
+    file.cancelWriting();
+  } else if (!file.commit()) {
+    success = false;
+    errorString = file.errorString();
+  }
+  emit finished(success, errorString); // the job can be deleted as soon as this is delivered, so it must be the last thing done here
+}
@@ -0,0 +1,41 @@
+#ifndef EXPORTJOB_H
+#define EXPORTJOB_H
+
+#include <QObject>
+#include <QSaveFile>
+
+#include <atomic>
+#include <functional>
+
+#include "Export.h"
+
+// Writes one file in a thread of the global pool, so formatting and disk I/O never block the window.
+// The file is replaced only when the whole export succeeds, a failed or cancelled export leaves the previous file untouched.
+class ExportJob : public QObject {
+  Q_OBJECT
+public:
+  using Writer = std::function<bool(QIODevice& device, const Export::ProgressCallback& progress)>; // runs in the pool thread
+
+  ExportJob(const QString& fileName, QIODevice::OpenMode mode, Writer writer, QObject* parent = nullptr);
+
+public:
+  const QString& fileName() const { return outputName; }
+  void start();
+  void cancel(); // can be called from any thread, the job still finishes with finished(false)
+
+signals:
+  void progressChanged(int percent);
+  void finished(bool success, const QString& errorString); // errorString is empty when the job was cancelled
+
+private:
+  void run();
+
+private:
+  const QString outputName;
+  const QIODevice::OpenMode openMode;
+  const Writer writer;
+  std::atomic_bool canceled{false};
+  int lastPercent = -1; // used only by the pool thread
+};
+
+#endif // EXPORTJOB_H
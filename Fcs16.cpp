@@ -0,0 +1,141 @@
+#include "Fcs16.h"
+
+#if defined(Q_PROCESSOR_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define FCS16_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#include <wmmintrin.h>
+#define FCS16_TARGET_CLMUL __attribute__((target("pclmul,sse2")))
+#endif
+#endif
+
+namespace Fcs16 {
+namespace {
+// Returns x^n mod P(x), with P(x) = x^16 + x^12 + x^5 + 1, bit-reflected in 64 bits (coefficient of x^i at bit 63 - i).
+// Carry-less product of such constant and 64 bits of reflected data ends up one bit short, so the exponents used below are lowered by one.
+constexpr quint64 foldConstant(uint n) {
+  uint rem = 1;
+  for (uint i = 0; i < n; i++) {
+    rem <<= 1;
+    if (rem & 0x10000)
+      rem ^= 0x11021;
+  }
+
+  quint64 res = 0;
+  for (uchar i = 0; i < 16; i++)
+    if (rem & (1u << i))
+      res |= quint64(1) << (63 - i);
+  return res;
+}
+
+constexpr quint64 fold128Low = foldConstant(128 + 63), fold128High = foldConstant(128 - 1);
+constexpr quint64 fold512Low = foldConstant(512 + 63), fold512High = foldConstant(512 - 1);
+
+using Kernel = ushort (*)(ushort, const uchar*, qsizetype);
+
+Kernel selectKernel() { return clmulSupported() ? updateClmul : updateSlicingBy8; }
+} // namespace
+
+ushort updateSlicingBy8(ushort fcs, const uchar* data, qsizetype len) {
+  const SlicingTables& t = slicingTables;
+
+  while (len >= 8) {
+    const ushort x = fcs ^ (data[0] | (data[1] << 8));
+    fcs = t[7][x & 0xFF] ^ t[6][x >> 8] ^ t[5][data[2]] ^ t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data += 8;
+    len -= 8;
+  }
+  return updateBytewise(fcs, data, len);
+}
+
+#if defined(Q_PROCESSOR_X86)
+namespace {
+FCS16_TARGET_CLMUL inline __m128i fold(__m128i block, __m128i constants) {
+  return _mm_xor_si128(_mm_clmulepi64_si128(block, constants, 0x00), _mm_clmulepi64_si128(block, constants, 0x11));
+}
+} // namespace
+
+// Folds the data 128 bits at a time (4 blocks in parallel for long data) into a single 16 byte block that has the same remainder,
+// then finishes with the table kernel. The current FCS value is equivalent to XOR-ing it into the first two data bytes.
+FCS16_TARGET_CLMUL ushort updateClmul(ushort fcs, const uchar* data, qsizetype len) {
+  if (len < 32)
+    return updateSlicingBy8(fcs, data, len);
+
+  const __m128i k128 = _mm_set_epi64x(static_cast<qint64>(fold128High), static_cast<qint64>(fold128Low));
+  __m128i acc = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), _mm_cvtsi32_si128(fcs));
+  data += 16;
+  len -= 16;
+
+  if (len >= 112) {
+    const __m128i k512 = _mm_set_epi64x(static_cast<qint64>(fold512High), static_cast<qint64>(fold512Low));
+    __m128i acc1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    __m128i acc2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+    __m128i acc3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+    data += 48;
+    len -= 48;
+
+    while (len >= 64) {
+      acc = _mm_xor_si128(fold(acc, k512), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+      acc1 = _mm_xor_si128(fold(acc1, k512), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)));
+      acc2 = _mm_xor_si128(fold(acc2, k512), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)));
+      acc3 = _mm_xor_si128(fold(acc3, k512), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)));
+      data += 64;
+      len -= 64;
+    }
+
+    acc = _mm_xor_si128(fold(acc, k128), acc1);
+    acc = _mm_xor_si128(fold(acc, k128), acc2);
+    acc = _mm_xor_si128(fold(acc, k128), acc3);
+  }
+
+  while (len >= 16) {
+    acc = _mm_xor_si128(fold(acc, k128), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+    data += 16;
+    len -= 16;
+  }
+
+  alignas(16) uchar folded[16];
+  _mm_store_si128(reinterpret_cast<__m128i*>(folded), acc);
+  return updateSlicingBy8(updateSlicingBy8(0, folded, sizeof(folded)), data, len);
+}
+
+bool clmulSupported() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  return info[2] & (1 << 1);
+#else
+  uint eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+  return ecx & bit_PCLMUL;
+#endif
+}
+#else
+ushort updateClmul(ushort fcs, const uchar* data, qsizetype len) { return updateSlicingBy8(fcs, data, len); }
+
+bool clmulSupported() { return false; }
+#endif
+
+ushort update(ushort fcs, const uchar* data, qsizetype len) {
+  static const Kernel kernel = selectKernel();
+  return kernel(fcs, data, len);
+}
+
+ushort update(ushort fcs, const RingBuffer::View& data) {
+  fcs = update(fcs, data.first().data, data.first().length);
+  return update(fcs, data.second().data, data.second().length);
+}
+
+PacketChecksums calculatePacketChecksums(const RingBuffer::View& packet, qsizetype packetLen) {
+  if (packetLen < 3) { // too short to be a real packet, but keep the results of the original byte-wise algorithm
+    const ushort fcs = update(initialFcs, packet.mid(0, packetLen));
+    return PacketChecksums{fcs, static_cast<ushort>(packetLen == 1 ? fcs ^ 0xFFFF : 0xFFFF)};
+  }
+
+  const ushort dataFcs = update(initialFcs, packet.mid(0, packetLen - 2));
+  return PacketChecksums{update(dataFcs, packet.mid(packetLen - 2, 2)), static_cast<ushort>(dataFcs ^ 0xFFFF)};
+}
+} // namespace Fcs16
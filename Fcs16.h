@@ -0,0 +1,64 @@
+#ifndef FCS16_H
+#define FCS16_H
+
+#include <array>
+
+#include "RingBuffer.h"
+
+// FCS16 (CRC-CCITT, reflected, polynomial 0x8408) used by type 2 packets. Lookup tables are generated at compile time.
+// Multi-byte kernels give exactly the same results as the classic byte-wise loop, the fastest one is selected at runtime.
+namespace Fcs16 {
+constexpr ushort initialFcs = 0xFFFF;
+constexpr ushort correctFcs = 0xF0B8; // value of FCS calculated over the data followed by its correct checksum
+constexpr ushort polynomial = 0x8408;
+
+using Table = std::array<ushort, 256>;
+using SlicingTables = std::array<Table, 8>;
+
+constexpr Table generateLookupTable() {
+  Table table{};
+  for (ushort b = 0; b < 256; b++) {
+    ushort v = b;
+    for (uchar i = 8; i > 0; i--)
+      v = (v & 1) ? (v >> 1) ^ polynomial : v >> 1;
+    table[b] = v;
+  }
+  return table;
+}
+
+// table n holds FCS of a byte followed by n zero bytes, so 8 bytes can be processed with 8 independent lookups
+constexpr SlicingTables generateSlicingTables() {
+  SlicingTables tables{};
+  tables[0] = generateLookupTable();
+  for (uchar n = 1; n < 8; n++)
+    for (ushort b = 0; b < 256; b++)
+      tables[n][b] = (tables[n - 1][b] >> 8) ^ tables[0][tables[n - 1][b] & 0xFF];
+  return tables;
+}
+
+inline constexpr Table lookupTable = generateLookupTable();
+inline constexpr SlicingTables slicingTables = generateSlicingTables();
+
+struct PacketChecksums {
+  ushort fcs;     // calculated over the whole packet (without trailer), equals correctFcs for a correct packet
+  ushort konnwei; // calculated over the packet without the checksum bytes, must be equal to the received checksum
+};
+
+inline ushort updateBytewise(ushort fcs, const uchar* data, qsizetype len) {
+  for (qsizetype i = 0; i < len; i++)
+    fcs = (fcs >> 8) ^ lookupTable[(fcs ^ data[i]) & 0xFF];
+  return fcs;
+}
+
+ushort updateSlicingBy8(ushort fcs, const uchar* data, qsizetype len);
+ushort updateClmul(ushort fcs, const uchar* data, qsizetype len); // requires PCLMULQDQ, check clmulSupported() first
+bool clmulSupported();
+
+ushort update(ushort fcs, const uchar* data, qsizetype len); // uses the fastest kernel supported by the CPU
+ushort update(ushort fcs, const RingBuffer::View& data);
+
+// Returns both checksums of a type 2 packet, packetLen is the length of the packet without trailer.
+PacketChecksums calculatePacketChecksums(const RingBuffer::View& packet, qsizetype packetLen);
+} // namespace Fcs16
+
+#endif // FCS16_H
@@ -0,0 +1,120 @@
+#include "FirmwareProtocol.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+#include "Fcs16.h"
+
+namespace FirmwareProtocol {
+namespace {
+quint32 readUint32(const RingBuffer::View& data, qsizetype pos) { return data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (quint32(data[pos + 3]) << 24); }
+
+quint16 readUint16(const RingBuffer::View& data, qsizetype pos) { return data[pos] | (data[pos + 1] << 8); }
+} // namespace
+
+bool isFirmwareType(uchar type) { return type >= uchar(Type::Start) && type <= uchar(Type::Done); }
+
+QByteArray packet(Type type, const uchar* payload, qsizetype len) {
+  const ushort packetLen = static_cast<ushort>(len + packetOverhead);
+  QByteArray res(packetLen, Qt::Uninitialized);
+  uchar* p = reinterpret_cast<uchar*>(res.data());
+  p[0] = p[1] = 0x24;
+  qToLittleEndian<quint16>(packetLen, p + 2);
+  p[4] = 0xFF;
+  p[5] = static_cast<uchar>(type);
+  memcpy(p + 6, payload, len);
+
+  // like in the chart packets, the complemented FCS is sent lower byte first, so the FCS of the whole packet ends up at the correct value
+  qToLittleEndian<quint16>(Fcs16::update(Fcs16::initialFcs, p, 6 + len) ^ 0xFFFF, p + 6 + len);
+  p[packetLen - 2] = '\r';
+  p[packetLen - 1] = '\n';
+  return res;
+}
+
+QByteArray start(const Start& start) {
+  uchar payload[8];
+  qToLittleEndian<quint32>(start.imageSize, payload);
+  qToLittleEndian<quint16>(start.blockSize, payload + 4);
+  qToLittleEndian<quint16>(start.imageFcs, payload + 6);
+  return packet(Type::Start, payload, sizeof(payload));
+}
+
+QByteArray ready(quint32 resumeBlock) {
+  uchar payload[4];
+  qToLittleEndian<quint32>(resumeBlock, payload);
+  return packet(Type::Ready, payload, sizeof(payload));
+}
+
+QByteArray block(quint32 index, const uchar* data, qsizetype len) {
+  QByteArray payload(blockHeaderSize + len, Qt::Uninitialized);
+  qToLittleEndian<quint32>(index, payload.data());
+  memcpy(payload.data() + blockHeaderSize, data, len);
+  return packet(Type::Block, reinterpret_cast<const uchar*>(payload.constData()), payload.size());
+}
+
+QByteArray blockAck(const BlockAck& ack) {
+  uchar payload[7];
+  qToLittleEndian<quint32>(ack.index, payload);
+  qToLittleEndian<quint16>(ack.fcs, payload + 4);
+  payload[6] = static_cast<uchar>(ack.status);
+  return packet(Type::BlockAck, payload, sizeof(payload));
+}
+
+QByteArray finish(quint16 imageFcs) {
+  uchar payload[2];
+  qToLittleEndian<quint16>(imageFcs, payload);
+  return packet(Type::Finish, payload, sizeof(payload));
+}
+
+QByteArray done(Status status) {
+  const uchar payload = static_cast<uchar>(status);
+  return packet(Type::Done, &payload, 1);
+}
+
+bool parseStart(const RingBuffer::View& payload, Start& start) {
+  if (payload.length() != 8)
+    return false;
+  start.imageSize = readUint32(payload, 0);
+  start.blockSize = readUint16(payload, 4);
+  start.imageFcs = readUint16(payload, 6);
+  return true;
+}
+
+bool parseReady(const RingBuffer::View& payload, quint32& resumeBlock) {
+  if (payload.length() != 4)
+    return false;
+  resumeBlock = readUint32(payload, 0);
+  return true;
+}
+
+bool parseBlockIndex(const RingBuffer::View& payload, quint32& index) {
+  if (payload.length() <= blockHeaderSize)
+    return false;
+  index = readUint32(payload, 0);
+  return true;
+}
+
+bool parseBlockAck(const RingBuffer::View& payload, BlockAck& ack) {
+  if (payload.length() != 7 || payload[6] > uchar(Status::Failed))
+    return false;
+  ack.index = readUint32(payload, 0);
+  ack.fcs = readUint16(payload, 4);
+  ack.status = static_cast<Status>(payload[6]);
+  return true;
+}
+
+bool parseFinish(const RingBuffer::View& payload, quint16& imageFcs) {
+  if (payload.length() != 2)
+    return false;
+  imageFcs = readUint16(payload, 0);
+  return true;
+}
+
+bool parseDone(const RingBuffer::View& payload, Status& status) {
+  if (payload.length() != 1 || payload[0] > uchar(Status::Failed))
+    return false;
+  status = static_cast<Status>(payload[0]);
+  return true;
+}
+} // namespace FirmwareProtocol
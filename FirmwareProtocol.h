@@ -0,0 +1,62 @@
+#ifndef FIRMWAREPROTOCOL_H
+#define FIRMWAREPROTOCOL_H
+
+#include <QByteArray>
+
+#include "RingBuffer.h"
+
+// Packets of the firmware update, see the firmware update section of README. They use the type 2 framing and FCS of the chart packets,
+// with their own packet types, all numbers are sent lower byte first. Payloads are parsed straight from the decoder's views.
+namespace FirmwareProtocol {
+enum class Type : uchar {
+  Start = 0x10,    // host: image size, block size and FCS of the whole image
+  Ready = 0x11,    // device: number of blocks of this image it already has, the transfer continues from there
+  Block = 0x12,    // host: block index and its data
+  BlockAck = 0x13, // device: block index, FCS of the block as it was written and the status
+  Finish = 0x14,   // host: FCS of the whole image once every block was acknowledged
+  Done = 0x15,     // device: status of the whole image
+};
+
+enum class Status : uchar {
+  Ok = 0,
+  Retry = 1,  // block was damaged or the device was busy, it should be sent again
+  Failed = 2, // the update can't continue, e.g. the image doesn't fit into the flash
+};
+
+constexpr qsizetype packetOverhead = 10;                           // header, FCS and trailer of a type 2 packet
+constexpr qsizetype blockHeaderSize = 4;                           // index of the block
+constexpr qsizetype maxBlockSize = 0xFFFF - packetOverhead - blockHeaderSize;
+
+bool isFirmwareType(uchar type);
+
+struct Start {
+  quint32 imageSize = 0;
+  quint16 blockSize = 0;
+  quint16 imageFcs = 0;
+};
+
+struct BlockAck {
+  quint32 index = 0;
+  quint16 fcs = 0;
+  Status status = Status::Ok;
+};
+
+// type 2 packet with the given type and payload
+QByteArray packet(Type type, const uchar* payload, qsizetype len);
+QByteArray start(const Start& start);
+QByteArray ready(quint32 resumeBlock);
+QByteArray block(quint32 index, const uchar* data, qsizetype len);
+QByteArray blockAck(const BlockAck& ack);
+QByteArray finish(quint16 imageFcs);
+QByteArray done(Status status);
+
+// Parsers return false for a payload of a wrong length.
+bool parseStart(const RingBuffer::View& payload, Start& start);
+bool parseReady(const RingBuffer::View& payload, quint32& resumeBlock);
+bool parseBlockIndex(const RingBuffer::View& payload, quint32& index); // data of the block follows the index
+bool parseBlockAck(const RingBuffer::View& payload, BlockAck& ack);
+bool parseFinish(const RingBuffer::View& payload, quint16& imageFcs);
+bool parseDone(const RingBuffer::View& payload, Status& status);
+} // namespace FirmwareProtocol
+
+#endif // FIRMWAREPROTOCOL_H
@@ -0,0 +1,195 @@
+#include "FirmwareUpdater.h"
+
+#include <limits>
+
+#include "Fcs16.h"
+#include "Trace.h"
+
+FirmwareUpdater::FirmwareUpdater(const Transport& transport, const Config& config, QObject* parent) : QObject{parent}, transport(transport), cfg(config) {
+  timeoutTimer.setInterval(qMax(cfg.timeoutMs / 4, 1)); // late answers are noticed within a quarter of the timeout
+  connect(&timeoutTimer, &QTimer::timeout, this, &FirmwareUpdater::checkTimeouts);
+}
+
+void FirmwareUpdater::start(const QString& imageFileName) {
+  cancel();
+  state = State::Starting; // from now on every way out goes through finish()
+  if (cfg.blockSize == 0 || cfg.blockSize > FirmwareProtocol::maxBlockSize || cfg.window < 1) {
+    finish(false, tr("Invalid transfer settings."));
+    return;
+  }
+
+  imageFile.setFileName(imageFileName);
+  if (!imageFile.open(QFile::ReadOnly)) {
+    finish(false, imageFile.errorString());
+    return;
+  }
+  imageSize = imageFile.size();
+  if (imageSize == 0 || imageSize > std::numeric_limits<quint32>::max()) {
+    finish(false, tr("The firmware image is empty or too large."));
+    return;
+  }
+  image = imageFile.map(0, imageSize); // blocks are sent straight from the mapping, the image is never copied as a whole
+  if (image == nullptr) {
+    finish(false, imageFile.errorString());
+    return;
+  }
+
+  imageFcs = Fcs16::update(Fcs16::initialFcs, image, imageSize);
+  blockCount = (imageSize + cfg.blockSize - 1) / cfg.blockSize;
+  blocks.fill(BlockState::Waiting, blockCount);
+  sentNs.fill(0, blockCount);
+  retries.fill(0, blockCount);
+  windowStart = nextBlock = 0;
+  resumeBlock = 0;
+  retransmissions = 0;
+  lineFreeNs = 0;
+  clock.start();
+  timeoutTimer.start();
+  sendRequest(FirmwareProtocol::start(FirmwareProtocol::Start{static_cast<quint32>(imageSize), cfg.blockSize, imageFcs}));
+}
+
+void FirmwareUpdater::cancel() {
+  if (isRunning())
+    finish(false, QString());
+}
+
+void FirmwareUpdater::handlePacket(uchar type, const RingBuffer::View& payload) {
+  FirmwareProtocol::BlockAck ack;
+  FirmwareProtocol::Status status;
+  quint32 resume;
+  // anything unexpected is a late answer to a repeated request or block, it's ignored
+  if (type == uchar(FirmwareProtocol::Type::Ready) && state == State::Starting && FirmwareProtocol::parseReady(payload, resume))
+    onReady(resume);
+  else if (type == uchar(FirmwareProtocol::Type::BlockAck) && state == State::Sending && FirmwareProtocol::parseBlockAck(payload, ack))
+    onBlockAck(ack);
+  else if (type == uchar(FirmwareProtocol::Type::Done) && isRunning() && FirmwareProtocol::parseDone(payload, status)) {
+    if (state == State::Finishing && status == FirmwareProtocol::Status::Ok)
+      finish(true, QString());
+    else if (state == State::Finishing || status == FirmwareProtocol::Status::Failed) // the device can refuse the update at any time
+      finish(false, state == State::Finishing ? tr("The tester rejected the firmware image.") : tr("The tester refused the firmware update."));
+  }
+}
+
+void FirmwareUpdater::onReady(quint32 resume) {
+  resumeBlock = static_cast<quint32>(qMin(static_cast<qsizetype>(resume), blockCount));
+  for (qsizetype i = 0; i < resumeBlock; i++)
+    blocks[i] = BlockState::Acknowledged;
+  windowStart = nextBlock = resumeBlock;
+  request.clear();
+  state = State::Sending;
+  emit progressChanged(acknowledgedBytes(), imageSize);
+  if (isRunning()) // unless the update was cancelled by a receiver of the signal
+    fillWindow();
+}
+
+void FirmwareUpdater::onBlockAck(const FirmwareProtocol::BlockAck& ack) {
+  const qsizetype index = ack.index;
+  if (index < windowStart || index >= nextBlock || blocks[index] == BlockState::Acknowledged)
+    return; // acknowledgement of a block that was sent twice
+
+  if (ack.status == FirmwareProtocol::Status::Failed) {
+    finish(false, tr("The tester couldn't write block %1 of the firmware.").arg(index));
+    return;
+  }
+  const qint64 offset = static_cast<qint64>(index) * cfg.blockSize;
+  const ushort fcs = Fcs16::update(Fcs16::initialFcs, image + offset, qMin(static_cast<qint64>(cfg.blockSize), imageSize - offset));
+  if (ack.status == FirmwareProtocol::Status::Retry || ack.fcs != fcs) {
+    resendBlock(index);
+    return;
+  }
+
+  blocks[index] = BlockState::Acknowledged;
+  const qsizetype previousStart = windowStart;
+  while (windowStart < nextBlock && blocks[windowStart] == BlockState::Acknowledged)
+    windowStart++;
+  if (windowStart != previousStart)
+    emit progressChanged(acknowledgedBytes(), imageSize);
+  if (isRunning())
+    fillWindow();
+}
+
+void FirmwareUpdater::fillWindow() {
+  while (nextBlock < blockCount && nextBlock - windowStart < cfg.window)
+    if (!sendBlock(nextBlock++))
+      return;
+
+  if (windowStart == blockCount) {
+    state = State::Finishing;
+    sendRequest(FirmwareProtocol::finish(imageFcs));
+  }
+}
+
+bool FirmwareUpdater::sendBlock(qsizetype index) {
+  Trace::Span span("FirmwareUpdater::sendBlock");
+  span.setArg("block", index);
+  const qint64 offset = static_cast<qint64>(index) * cfg.blockSize;
+  blocks[index] = BlockState::Sent;
+  sentNs[index] = write(FirmwareProtocol::block(static_cast<quint32>(index), image + offset, qMin(static_cast<qint64>(cfg.blockSize), imageSize - offset)));
+  if (sentNs[index] < 0) {
+    finish(false, tr("Unable to send the data to the tester."));
+    return false;
+  }
+  return true;
+}
+
+bool FirmwareUpdater::resendBlock(qsizetype index) {
+  if (++retries[index] > cfg.maxRetries) {
+    finish(false, tr("Block %1 of the firmware couldn't be delivered in %2 attempts.").arg(index).arg(cfg.maxRetries + 1));
+    return false;
+  }
+  retransmissions++;
+  return sendBlock(index);
+}
+
+bool FirmwareUpdater::sendRequest(const QByteArray& packet) {
+  request = packet;
+  requestRetries = 0;
+  requestSentNs = write(request);
+  if (requestSentNs < 0) {
+    finish(false, tr("Unable to send the data to the tester."));
+    return false;
+  }
+  return true;
+}
+
+// The port buffers everything that is written, so a packet waits for the ones before it. A whole window can take seconds to send
+// on a slow line, timing it from the write would send again blocks that are still waiting in the buffer.
+qint64 FirmwareUpdater::write(const QByteArray& packet) {
+  if (!transport(packet))
+    return -1;
+  const qint64 now = clock.nsecsElapsed();
+  lineFreeNs = cfg.bytesPerSecond > 0 ? qMax(lineFreeNs, now) + packet.size() * 1000000000LL / cfg.bytesPerSecond : now;
+  return lineFreeNs;
+}
+
+void FirmwareUpdater::checkTimeouts() {
+  const qint64 now = clock.nsecsElapsed(), timeoutNs = static_cast<qint64>(cfg.timeoutMs) * 1000000;
+  if (state == State::Starting || state == State::Finishing) {
+    if (now - requestSentNs < timeoutNs)
+      return;
+    if (++requestRetries > cfg.maxRetries) {
+      finish(false, tr("The tester doesn't respond."));
+      return;
+    }
+    requestSentNs = write(request);
+    if (requestSentNs < 0)
+      finish(false, tr("Unable to send the data to the tester."));
+    return;
+  }
+
+  // only the blocks that timed out are sent again, the rest of the window is still on its way
+  for (qsizetype i = windowStart; i < nextBlock && state == State::Sending; i++)
+    if (blocks[i] == BlockState::Sent && now - sentNs[i] >= timeoutNs)
+      resendBlock(i);
+}
+
+void FirmwareUpdater::finish(bool success, const QString& errorString) {
+  timeoutTimer.stop();
+  state = State::Idle;
+  if (image != nullptr)
+    imageFile.unmap(const_cast<uchar*>(image));
+  image = nullptr;
+  imageFile.close();
+  request.clear();
+  emit finished(success, errorString);
+}
@@ -0,0 +1,91 @@
+#ifndef FIRMWAREUPDATER_H
+#define FIRMWAREUPDATER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+#include "FirmwareProtocol.h"
+#include "RingBuffer.h"
+
+// Sends a firmware image to the bootloader of the tester. The image is memory-mapped and sent in blocks, a window of blocks is sent
+// before the first of them is acknowledged, so the link isn't idle while the device writes its flash. Every acknowledgement carries
+// the FCS of the block as the device wrote it, a block with a wrong FCS or without an acknowledgement in time is sent again, alone.
+// When an update is interrupted, on the next start the device reports how many blocks of the same image it already has,
+// and the transfer continues from there. Lives in the thread of the serial port, like the decoder that passes it the answers.
+class FirmwareUpdater : public QObject {
+  Q_OBJECT
+public:
+  using Transport = std::function<bool(const QByteArray& packet)>; // writes a packet to the device, returns false on error
+
+  struct Config {
+    quint16 blockSize = 1024;
+    int window = 8;       // blocks sent without waiting for their acknowledgements, 1 means stop-and-wait
+    int timeoutMs = 1000; // a block or a request is sent again when its answer doesn't arrive in time after it left the line
+    qint64 bytesPerSecond = 11520; // of the line, 0 for unlimited, 11520 is 115200 baud
+    int maxRetries = 5;   // of a single block or request, then the update fails
+  };
+
+  FirmwareUpdater(const Transport& transport, const Config& config, QObject* parent = nullptr);
+
+public:
+  bool isRunning() const { return state != State::Idle; }
+  void start(const QString& imageFileName); // the result is always reported with finished(), an update in progress is cancelled
+  void cancel();                            // finishes with finished(false) and an empty error string
+  void handlePacket(uchar type, const RingBuffer::View& payload); // firmware packets received from the device, see FrameDecoder
+
+  quint32 resumedBlocks() const { return resumeBlock; } // blocks the device already had when the update started
+  quint64 retransmittedBlocks() const { return retransmissions; }
+
+signals:
+  void progressChanged(qint64 doneBytes, qint64 totalBytes); // acknowledged part of the image
+  void finished(bool success, const QString& errorString);
+
+private:
+  enum class State : uchar { Idle, Starting, Sending, Finishing };
+  enum class BlockState : uchar { Waiting, Sent, Acknowledged };
+
+  void onReady(quint32 resume);
+  void onBlockAck(const FirmwareProtocol::BlockAck& ack);
+  void fillWindow();
+  bool sendBlock(qsizetype index);
+  bool resendBlock(qsizetype index);
+  bool sendRequest(const QByteArray& packet); // start or finish, sent again until it's answered
+  qint64 write(const QByteArray& packet);     // returns when the packet will have left the line, -1 on error
+  void checkTimeouts();
+  void finish(bool success, const QString& errorString);
+  qint64 acknowledgedBytes() const { return qMin(static_cast<qint64>(windowStart) * cfg.blockSize, imageSize); }
+
+private:
+  const Transport transport;
+  const Config cfg;
+  State state = State::Idle;
+
+  QFile imageFile;
+  const uchar* image = nullptr; // mapped image file
+  qint64 imageSize = 0;
+  quint16 imageFcs = 0;
+
+  qsizetype blockCount = 0;
+  qsizetype windowStart = 0; // the first block that wasn't acknowledged
+  qsizetype nextBlock = 0;   // the first block that wasn't sent yet
+  QVector<BlockState> blocks;
+  QVector<qint64> sentNs; // when the block sent the last time left the line, its timeout starts then
+  QVector<uchar> retries;
+
+  QByteArray request; // start or finish packet waiting for its answer
+  qint64 requestSentNs = 0;
+  qint64 lineFreeNs = 0; // when the data written so far will have been sent
+  int requestRetries = 0;
+
+  quint32 resumeBlock = 0;
+  quint64 retransmissions = 0;
+  QTimer timeoutTimer;
+  QElapsedTimer clock;
+};
+
+#endif // FIRMWAREUPDATER_H
@@ -0,0 +1,169 @@
+#include "FrameDecoder.h"
+
+#include "FirmwareProtocol.h"
+#include "Trace.h"
+
+FrameDecoder::FrameDecoder(QObject* parent) : QObject{parent} {}
+
+qsizetype FrameDecoder::decode(const RingBuffer::View& pendingData) {
+  const qsizetype dataLen = pendingData.length();
+  Trace::Span span("FrameDecoder::decode");
+  span.setArg("bytes", dataLen - scanPos);
+
+  while (scanPos < dataLen) {
+    if (state == State::Type2Body && scanPos - frameStart < frameLength - 4) { // packet data can be checked in bulk
+      const qsizetype chunk = qMin(dataLen - scanPos, frameLength - 4 - (scanPos - frameStart));
+      currentFcs = Fcs16::update(currentFcs, pendingData.mid(scanPos, chunk));
+      scanPos += chunk;
+      continue;
+    }
+
+    const uchar b = pendingData[scanPos];
+    bool byteOk = true;
+
+    switch (state) {
+    case State::Hunt: // look for 0x24, 0x24 (optionally preceded by 0x00) which starts every packet
+      if (b == 0x24 && scanPos > 0 && pendingData[scanPos - 1] == 0x24) {
+        headerPos = scanPos - 1;
+        frameStart = (headerPos > huntStart && pendingData[headerPos - 1] == 0x00) ? headerPos - 1 : headerPos;
+        state = State::Header;
+      }
+      break;
+    case State::Header:
+      if (scanPos - headerPos == 5) // we have packet type, so the header can be checked
+        byteOk = processHeader(pendingData);
+      break;
+    case State::BattInfoText:
+      byteOk = processBattInfoByte(pendingData, b);
+      break;
+    case State::Type2Body:
+      byteOk = processType2Byte(pendingData, b);
+      break;
+    }
+
+    if (byteOk)
+      scanPos++;
+    else
+      resync();
+  }
+
+  // bytes before the packet being decoded aren't needed anymore, while hunting keep the last two bytes as they can be the start of a header
+  qsizetype consumable = (state == State::Hunt) ? scanPos - 2 : frameStart;
+  if (consumable <= 0)
+    return 0;
+
+  if (consumable > huntStart)
+    droppedBytes += consumable - huntStart;
+  huntStart = qMax(huntStart - consumable, qsizetype(0));
+  scanPos -= consumable;
+  headerPos -= consumable;
+  frameStart -= consumable;
+  return consumable;
+}
+
+void FrameDecoder::reset() {
+  state = State::Hunt;
+  packetType = PacketType::Unknown;
+  scanPos = huntStart = headerPos = frameStart = droppedBytes = 0;
+}
+
+bool FrameDecoder::processHeader(const RingBuffer::View& pendingData) {
+  const uchar lenLow = pendingData[headerPos + 2], lenHigh = pendingData[headerPos + 3];
+  const uchar typeHigh = pendingData[headerPos + 4], typeLow = pendingData[headerPos + 5];
+
+  if (frameStart != headerPos && lenLow == 0xFF && lenHigh == 0xFE) { // type 1 packet, the last two header bytes are the code page
+    packetType = PacketType::BattInfo;
+    linesReceived = 0;
+    state = State::BattInfoText;
+    droppedBytes += frameStart - huntStart;
+    huntStart = frameStart; // counted, so decode() doesn't count them again when the packet spans more calls
+    return true;
+  }
+
+  frameStart = headerPos; // if 0x00 was before the header, then it's not a part of type 2 packet
+  frameLength = (lenHigh << 8) | lenLow;
+  if (typeHigh != 0xFF || frameLength < type2MinLength)
+    return false;
+  if (typeLow == 0x01 && !(frameLength & 1)) // samples are 2 bytes each
+    packetType = PacketType::Chart;
+  else if (typeLow == 0x02 && frameLength == type2MinLength)
+    packetType = PacketType::ChartDisplay;
+  else if (FirmwareProtocol::isFirmwareType(typeLow)) {
+    packetType = PacketType::Firmware;
+    firmwareType = typeLow;
+  } else
+    return false;
+
+  currentFcs = Fcs16::update(Fcs16::initialFcs, pendingData.mid(headerPos, 6));
+  state = State::Type2Body;
+  droppedBytes += frameStart - huntStart;
+  huntStart = frameStart;
+  return true;
+}
+
+bool FrameDecoder::processBattInfoByte(const RingBuffer::View& pendingData, uchar b) {
+  const qsizetype textStart = frameStart + 7;
+
+  if (b < 0x20 && b != '\r' && b != '\n')
+    return false; // text can't contain control characters, so probably a part of the packet was lost
+  if (scanPos - textStart > battInfoMaxLength)
+    return false;
+
+  if (b == '\n' && scanPos > textStart && pendingData[scanPos - 1] == '\r' && ++linesReceived == battInfoLines) {
+    emit battInfoFrameReceived(pendingData.mid(textStart, scanPos - 1 - textStart));
+    frameFinished();
+  }
+  return true;
+}
+
+bool FrameDecoder::processType2Byte(const RingBuffer::View& pendingData, uchar b) {
+  const qsizetype pos = scanPos - frameStart;
+
+  if (pos < frameLength - 2) { // checksum, data before it was already checked in bulk
+    if (pos == frameLength - 4)
+      checksumKonnwei = currentFcs ^ 0xFFFF; // konnwei checksum covers everything up to the checksum itself
+    currentFcs = Fcs16::updateBytewise(currentFcs, &b, 1);
+
+    if (pos == frameLength - 3) {
+      const ushort receivedChecksum = (b << 8) | pendingData[scanPos - 1];
+      // check if standard data checksum is correct and if konnwei checksum is correct
+      if (currentFcs != Fcs16::correctFcs || receivedChecksum != checksumKonnwei) {
+        emit checksumFailed();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (pos == frameLength - 2)
+    return b == '\r';
+
+  if (b != '\n')
+    return false;
+
+  if (packetType == PacketType::Chart)
+    emit chartFrameReceived(pendingData.mid(frameStart + 6, frameLength - type2MinLength));
+  else if (packetType == PacketType::Firmware)
+    emit firmwareFrameReceived(firmwareType, pendingData.mid(frameStart + 6, frameLength - type2MinLength));
+  else
+    emit chartDisplayFrameReceived();
+  frameFinished();
+  return true;
+}
+
+void FrameDecoder::frameFinished() {
+  if (droppedBytes)
+    emit resynchronised(droppedBytes);
+  droppedBytes = 0;
+  huntStart = scanPos + 1; // current byte is the last one of the packet
+  state = State::Hunt;
+  packetType = PacketType::Unknown;
+}
+
+void FrameDecoder::resync() {
+  // start looking for the next header right after the first header byte of the broken packet,
+  // data between them will be counted as dropped once we find a correct packet
+  scanPos = headerPos + 2;
+  state = State::Hunt;
+  packetType = PacketType::Unknown;
+}
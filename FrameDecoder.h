@@ -0,0 +1,60 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QObject>
+
+#include "Fcs16.h"
+#include "RingBuffer.h"
+
+// Incremental decoder of the packets sent by the tester. It keeps its parse state between calls, so every received byte is looked at once
+// and the checksum is updated as the data arrives. On any error it resynchronises on the next header instead of dropping the buffered data.
+// Views passed with the signals point into the decoded data and are valid only during the emission, so connect to them directly.
+class FrameDecoder : public QObject {
+  Q_OBJECT
+public:
+  explicit FrameDecoder(QObject* parent = nullptr);
+
+public:
+  // Decodes the data that wasn't decoded yet and returns how many bytes from the start of pendingData are no longer needed.
+  // Exactly that many bytes must be removed from the start of the data before the next call.
+  qsizetype decode(const RingBuffer::View& pendingData);
+  void reset(); // forgets the parse state, call it whenever the buffered data is cleared
+
+signals:
+  void battInfoFrameReceived(const RingBuffer::View& text); // type 1 packet, text without header, code page and trailer
+  void chartFrameReceived(const RingBuffer::View& samples); // type 2 voltage waveform packet, 2 bytes for each sample
+  void chartDisplayFrameReceived();                         // type 2 chart display packet
+  void firmwareFrameReceived(uchar type, const RingBuffer::View& payload); // type 2 packet of the firmware update, see FirmwareProtocol
+  void checksumFailed();                                    // type 2 packet with incorrect FCS or Konnwei checksum
+  void resynchronised(qsizetype droppedBytes);              // data that wasn't a valid packet was skipped before the last packet
+
+private:
+  enum class State : uchar { Hunt, Header, BattInfoText, Type2Body };
+  enum class PacketType : uchar { Unknown, BattInfo, Chart, ChartDisplay, Firmware };
+
+  bool processHeader(const RingBuffer::View& pendingData);
+  bool processBattInfoByte(const RingBuffer::View& pendingData, uchar b);
+  bool processType2Byte(const RingBuffer::View& pendingData, uchar b);
+  void frameFinished();
+  void resync();
+
+private:
+  static constexpr ushort type2MinLength = 10;     // header, FCS and trailer
+  static constexpr uchar battInfoLines = 7;        // the last line is terminated by the packet trailer
+  static constexpr ushort battInfoMaxLength = 512; // more than enough for the longest translation of the text
+
+  State state = State::Hunt;
+  PacketType packetType = PacketType::Unknown;
+  qsizetype scanPos = 0;      // position of the next byte to look at
+  qsizetype huntStart = 0;    // position where the search for the next header started
+  qsizetype headerPos = 0;    // position of the first 0x24 header byte of the packet being decoded
+  qsizetype frameStart = 0;   // position of the first byte of the packet being decoded
+  qsizetype droppedBytes = 0; // bytes skipped since the last packet
+  ushort frameLength = 0;     // type 2 packet length, including header and trailer
+  ushort currentFcs = Fcs16::initialFcs;
+  ushort checksumKonnwei = 0;
+  uchar linesReceived = 0;
+  uchar firmwareType = 0;
+};
+
+#endif // FRAMEDECODER_H
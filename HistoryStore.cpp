@@ -0,0 +1,430 @@
+#include "HistoryStore.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include "Fcs16.h"
+#include "WaveformCodec.h"
+
+namespace {
+void appendString(QByteArray& data, const QString& text) {
+  const QByteArray utf8 = text.toUtf8().left(std::numeric_limits<quint16>::max());
+  uchar len[2];
+  qToLittleEndian<quint16>(utf8.size(), len);
+  data.append(reinterpret_cast<const char*>(len), sizeof(len));
+  data.append(utf8);
+}
+
+bool readString(const uchar*& pos, const uchar* end, QString& text) {
+  if (end - pos < 2)
+    return false;
+  const quint16 len = qFromLittleEndian<quint16>(pos);
+  if (end - pos - 2 < len)
+    return false;
+  text = QString::fromUtf8(reinterpret_cast<const char*>(pos + 2), len);
+  pos += 2 + len;
+  return true;
+}
+
+quint32 recordLength(const uchar* rec) { return qFromLittleEndian<quint32>(rec + 4); }
+
+// header of a record that fits into the file, its FCS isn't checked
+bool plausibleRecord(const uchar* mapped, qint64 size, qint64 pos) {
+  if (size - pos < HistoryFormat::recordHeaderSize)
+    return false;
+  const uchar* rec = mapped + pos;
+  const quint32 length = recordLength(rec);
+  const quint16 deviceLen = qFromLittleEndian<quint16>(rec + 20), conditionLen = qFromLittleEndian<quint16>(rec + 22);
+  return qFromLittleEndian<quint32>(rec) == HistoryFormat::recordMagic && length <= size - pos
+         && length >= HistoryFormat::recordHeaderSize + deviceLen + conditionLen + HistoryFormat::recordTrailerSize;
+}
+
+bool intactRecord(const uchar* mapped, qint64 size, qint64 pos) {
+  return plausibleRecord(mapped, size, pos) && Fcs16::update(Fcs16::initialFcs, mapped + pos, recordLength(mapped + pos)) == Fcs16::correctFcs;
+}
+
+// position of the first intact record at or after pos, -1 when there is none
+qint64 findRecord(const uchar* mapped, qint64 size, qint64 pos) {
+  for (; size - pos >= HistoryFormat::recordHeaderSize; pos++)
+    if (qFromLittleEndian<quint32>(mapped + pos) == HistoryFormat::recordMagic && intactRecord(mapped, size, pos))
+      return pos;
+  return -1;
+}
+} // namespace
+
+bool HistoryStore::open(const QString& fileName) {
+  close();
+  file.setFileName(fileName);
+  if (!file.open(QFile::ReadWrite)) {
+    error = file.errorString();
+    return false;
+  }
+
+  if (file.size() < HistoryFormat::headerSize) { // new history, or the header of a new one wasn't written completely
+    uchar header[HistoryFormat::headerSize] = {};
+    memcpy(header, HistoryFormat::magic, sizeof(HistoryFormat::magic));
+    qToLittleEndian<quint32>(HistoryFormat::version, header + 8);
+    if (!file.resize(0) || file.write(reinterpret_cast<const char*>(header), sizeof(header)) != sizeof(header) || !file.flush()) {
+      error = file.errorString();
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  if (!scan()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void HistoryStore::close() {
+  if (file.isOpen())
+    file.close();
+  entries.clear();
+  deviceNames.clear();
+  conditionNames.clear();
+  deviceIds.clear();
+  conditionIds.clear();
+  devicePostings.clear();
+  conditionPostings.clear();
+  skippedBytes = 0;
+}
+
+bool HistoryStore::appendBattInfo(const QString& device, qint64 timestampMs, const BattInfo& info) {
+  QByteArray payload;
+  appendString(payload, info.testNorm);
+  appendString(payload, info.testResult);
+  appendString(payload, info.resistance);
+  appendString(payload, info.voltage);
+  return appendRecord(device, timestampMs, Kind::BattInfo, qBound(0, info.soh, 255), qBound(0, info.soc, 255), info.condition, payload);
+}
+
+bool HistoryStore::appendWaveform(const QString& device, qint64 timestampMs, const Waveform& waveform, const WaveformMetrics& metrics, const BattInfo* info) {
+  constexpr qsizetype samplesStart = 8 + HistoryFormat::metricsSize;
+  QByteArray payload(samplesStart + WaveformCodec::maxEncodedSize(waveform.size()), Qt::Uninitialized);
+  uchar* data = reinterpret_cast<uchar*>(payload.data());
+  qToLittleEndian<quint32>(waveform.timebase().sampleIntervalUs, data);
+  qToLittleEndian<quint32>(waveform.size(), data + 4);
+  const double values[] = {metrics.minVoltage, metrics.dipTime, metrics.recoverySlope, metrics.timeUnderThreshold, metrics.rippleRms, metrics.settleVoltage};
+  for (qsizetype i = 0; i < 6; i++) {
+    quint64 bits;
+    memcpy(&bits, &values[i], sizeof(bits));
+    qToLittleEndian<quint64>(bits, data + 8 + i * 8);
+  }
+  payload.truncate(samplesStart + WaveformCodec::encode(waveform.constData(), waveform.size(), data + samplesStart));
+  return appendRecord(device, timestampMs, Kind::Waveform, info ? qBound(0, info->soh, 255) : 0, info ? qBound(0, info->soc, 255) : 0, info ? info->condition : QString(),
+                      payload, HistoryFormat::packedWaveformMetrics);
+}
+
+QVector<qsizetype> HistoryStore::query(const Query& query) const {
+  QVector<qsizetype> res;
+  int device = -1, condition = -1;
+  const QVector<qsizetype>* postings = nullptr; // the shortest list of entries that can match, all entries when null
+  if (!query.device.isEmpty()) {
+    device = deviceIds.value(query.device, -1);
+    if (device < 0)
+      return res;
+    postings = &devicePostings[device];
+  }
+  if (!query.condition.isEmpty()) {
+    condition = conditionIds.value(query.condition, -1);
+    if (condition < 0)
+      return res;
+    if (!postings || conditionPostings[condition].size() < postings->size())
+      postings = &conditionPostings[condition];
+  }
+
+  const auto entryAt = [&](qsizetype pos) { return postings ? (*postings)[pos] : pos; };
+  const auto firstAfter = [&](qint64 timestampMs, bool inclusive) { // binary search, the list is sorted by time
+    qsizetype low = 0, high = postings ? postings->size() : entries.size();
+    while (low < high) {
+      const qsizetype mid = low + (high - low) / 2;
+      const qint64 t = entries[entryAt(mid)].timestampMs;
+      if (t < timestampMs || (!inclusive && t == timestampMs))
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    return low;
+  };
+
+  const qsizetype first = firstAfter(query.fromMs, true), last = firstAfter(query.toMs, false);
+  for (qsizetype pos = last - 1; pos >= first && (query.limit < 0 || res.size() < query.limit); pos--) { // newest first, so the limit keeps them
+    const Entry& e = entries[entryAt(pos)];
+    if ((device < 0 || e.device == device) && (condition < 0 || e.condition == condition) && (!query.kinds || (query.kinds & int(e.kind))))
+      res.append(entryAt(pos));
+  }
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+bool HistoryStore::readBattInfo(qsizetype index, BattInfo& info) {
+  QByteArray payload;
+  uchar encoding;
+  if (!readRecord(index, Kind::BattInfo, payload, encoding))
+    return false;
+
+  const Entry& e = entries[index];
+  const uchar* pos = reinterpret_cast<const uchar*>(payload.constData());
+  const uchar* end = pos + payload.size();
+  BattInfo res;
+  res.soh = e.soh;
+  res.soc = e.soc;
+  res.condition = conditionNames.value(e.condition);
+  if (!readString(pos, end, res.testNorm) || !readString(pos, end, res.testResult) || !readString(pos, end, res.resistance) || !readString(pos, end, res.voltage)) {
+    error = QStringLiteral("Damaged record.");
+    return false;
+  }
+  info = res;
+  return true;
+}
+
+bool HistoryStore::readWaveform(qsizetype index, Waveform& waveform, WaveformMetrics* metrics) {
+  if (index < 0 || index >= entries.size() || entries[index].kind != Kind::Waveform) {
+    error = QStringLiteral("No such test.");
+    return false;
+  }
+  return readWaveform(file, entries[index], waveform, metrics, error);
+}
+
+bool HistoryStore::readWaveform(QFile& file, const Entry& entry, Waveform& waveform, WaveformMetrics* metrics, QString& errorString) {
+  QByteArray payload;
+  uchar encoding;
+  if (!readRecord(file, entry, payload, encoding, errorString))
+    return false;
+
+  const uchar* data = reinterpret_cast<const uchar*>(payload.constData());
+  const qsizetype count = payload.size() >= 8 ? qFromLittleEndian<quint32>(data + 4) : -1;
+  QVector<ushort> samples(qMax(count, qsizetype(0)));
+  const bool withMetrics = encoding == HistoryFormat::packedWaveformMetrics && payload.size() >= 8 + HistoryFormat::metricsSize;
+  const qsizetype samplesStart = withMetrics ? 8 + HistoryFormat::metricsSize : 8;
+  bool valid = false;
+  if (count >= 0 && (encoding == HistoryFormat::packedWaveform || withMetrics)) {
+    valid = WaveformCodec::decode(data + samplesStart, payload.size() - samplesStart, samples.data(), count) == payload.size() - samplesStart;
+  } else if (count >= 0 && encoding == HistoryFormat::rawPayload && payload.size() - 8 == count * 2) {
+    qFromLittleEndian<quint16>(data + 8, count, samples.data());
+    valid = true;
+  }
+  if (!valid) {
+    errorString = QStringLiteral("Damaged record.");
+    return false;
+  }
+
+  waveform = Waveform(Timebase{qFromLittleEndian<quint32>(data)});
+  waveform.append(samples);
+
+  if (metrics && withMetrics) {
+    double values[6];
+    for (qsizetype i = 0; i < 6; i++) {
+      const quint64 bits = qFromLittleEndian<quint64>(data + 8 + i * 8);
+      memcpy(&values[i], &bits, sizeof(bits));
+    }
+    *metrics = WaveformMetrics{waveform.size() >= 2, values[0], values[1], values[2], values[3], values[4], values[5]};
+  } else if (metrics) {
+    *metrics = WaveformAnalysis::analyze(waveform);
+  }
+  return true;
+}
+
+bool HistoryStore::scan() {
+  const qint64 size = file.size();
+  uchar* mapped = file.map(0, size);
+  if (!mapped) {
+    error = file.errorString();
+    return false;
+  }
+  if (memcmp(mapped, HistoryFormat::magic, sizeof(HistoryFormat::magic)) || qFromLittleEndian<quint32>(mapped + 8) != HistoryFormat::version) {
+    file.unmap(mapped);
+    error = QStringLiteral("Unsupported file format.");
+    return false;
+  }
+
+  const auto dropEntry = [this](qint64 offset) {
+    entries.removeIf([offset](const Entry& e) { return e.offset == offset; });
+    rebuildPostings();
+  };
+
+  // only the headers are read, a record followed by another complete one was written completely, so FCS is checked only for the last one
+  // and around damaged data
+  qint64 pos = HistoryFormat::headerSize;
+  qint64 lastRecord = -1;
+  qint64 damageStart = -1; // damaged data that isn't followed by any intact record
+  while (pos < size) {
+    if (!plausibleRecord(mapped, size, pos)) {
+      // the damage can be in the length of the previous record as well, then the search starts right after its start
+      qint64 from = pos;
+      if (lastRecord >= 0 && !intactRecord(mapped, size, lastRecord)) {
+        dropEntry(lastRecord);
+        from = lastRecord;
+      }
+      lastRecord = -1;
+      const qint64 next = findRecord(mapped, size, from + 1);
+      if (next < 0) {
+        damageStart = from;
+        break;
+      }
+      skippedBytes += next - from; // records after the damaged data are kept, it's never cut off
+      pos = next;
+      continue;
+    }
+
+    const uchar* rec = mapped + pos;
+    const quint32 length = recordLength(rec);
+    const quint16 deviceLen = qFromLittleEndian<quint16>(rec + 20), conditionLen = qFromLittleEndian<quint16>(rec + 22);
+    Entry e;
+    e.timestampMs = qFromLittleEndian<qint64>(rec + 8);
+    e.offset = pos;
+    e.length = length;
+    e.kind = static_cast<Kind>(rec[16]);
+    e.soh = rec[17];
+    e.soc = rec[18];
+    const QString deviceName = QString::fromUtf8(reinterpret_cast<const char*>(rec + HistoryFormat::recordHeaderSize), deviceLen);
+    e.device = intern(deviceName, deviceNames, deviceIds, devicePostings);
+    if (e.kind == Kind::BattInfo || conditionLen > 0) // waveforms recorded without the battery state have no condition
+      e.condition = intern(QString::fromUtf8(reinterpret_cast<const char*>(rec + HistoryFormat::recordHeaderSize + deviceLen), conditionLen), conditionNames, conditionIds,
+                           conditionPostings);
+    addEntry(e);
+    lastRecord = pos;
+    pos += length;
+  }
+
+  qint64 end = size; // only a record that was being written when the application stopped is cut off
+  if (damageStart < 0 && lastRecord >= 0 && !intactRecord(mapped, size, lastRecord)) {
+    end = lastRecord; // interrupted while writing, drop the entry
+    dropEntry(lastRecord);
+  } else if (damageStart >= 0) {
+    const bool partial = size - damageStart < HistoryFormat::recordHeaderSize
+                         || (qFromLittleEndian<quint32>(mapped + damageStart) == HistoryFormat::recordMagic && recordLength(mapped + damageStart) > size - damageStart);
+    if (partial)
+      end = damageStart;
+    else
+      skippedBytes += size - damageStart; // new records are appended after it and found by the next scan
+  }
+  file.unmap(mapped);
+
+  if (end != size && !file.resize(end)) {
+    error = file.errorString();
+    return false;
+  }
+  return true;
+}
+
+bool HistoryStore::appendRecord(const QString& device, qint64 timestampMs, Kind kind, uchar soh, uchar soc, const QString& condition, const QByteArray& payload,
+                                uchar encoding) {
+  if (!file.isOpen())
+    return false;
+
+  const QByteArray deviceUtf8 = device.toUtf8().left(std::numeric_limits<quint16>::max());
+  const QByteArray conditionUtf8 = condition.toUtf8().left(std::numeric_limits<quint16>::max());
+  const qsizetype length = HistoryFormat::recordHeaderSize + deviceUtf8.size() + conditionUtf8.size() + payload.size() + HistoryFormat::recordTrailerSize;
+  if (length > std::numeric_limits<quint32>::max()) {
+    error = QStringLiteral("Record is too long.");
+    return false;
+  }
+
+  QByteArray record(length, Qt::Uninitialized);
+  uchar* rec = reinterpret_cast<uchar*>(record.data());
+  qToLittleEndian<quint32>(HistoryFormat::recordMagic, rec);
+  qToLittleEndian<quint32>(length, rec + 4);
+  qToLittleEndian<qint64>(timestampMs, rec + 8);
+  rec[16] = static_cast<uchar>(kind);
+  rec[17] = soh;
+  rec[18] = soc;
+  rec[19] = encoding;
+  qToLittleEndian<quint16>(deviceUtf8.size(), rec + 20);
+  qToLittleEndian<quint16>(conditionUtf8.size(), rec + 22);
+  uchar* pos = rec + HistoryFormat::recordHeaderSize;
+  memcpy(pos, deviceUtf8.constData(), deviceUtf8.size());
+  pos += deviceUtf8.size();
+  memcpy(pos, conditionUtf8.constData(), conditionUtf8.size());
+  pos += conditionUtf8.size();
+  memcpy(pos, payload.constData(), payload.size());
+  pos += payload.size();
+  qToLittleEndian<quint16>(Fcs16::update(Fcs16::initialFcs, rec, pos - rec) ^ 0xFFFF, pos);
+
+  const qint64 offset = file.size();
+  if (!file.seek(offset) || file.write(record) != length || !file.flush()) { // the whole record at once, with a single system call
+    error = file.errorString();
+    file.resize(offset);
+    return false;
+  }
+
+  Entry e;
+  e.timestampMs = timestampMs;
+  e.offset = offset;
+  e.length = length;
+  e.kind = kind;
+  e.soh = soh;
+  e.soc = soc;
+  e.device = intern(QString::fromUtf8(deviceUtf8), deviceNames, deviceIds, devicePostings); // the same name as the one read back from the file
+  if (kind == Kind::BattInfo || !conditionUtf8.isEmpty())
+    e.condition = intern(QString::fromUtf8(conditionUtf8), conditionNames, conditionIds, conditionPostings);
+  addEntry(e);
+  return true;
+}
+
+bool HistoryStore::readRecord(qsizetype index, Kind kind, QByteArray& payload, uchar& encoding) {
+  if (index < 0 || index >= entries.size() || entries[index].kind != kind) {
+    error = QStringLiteral("No such test.");
+    return false;
+  }
+  return readRecord(file, entries[index], payload, encoding, error);
+}
+
+bool HistoryStore::readRecord(QFile& file, const Entry& entry, QByteArray& payload, uchar& encoding, QString& errorString) {
+  QByteArray record;
+  if (!file.seek(entry.offset) || (record = file.read(entry.length)).size() != entry.length) {
+    errorString = file.errorString();
+    return false;
+  }
+  const uchar* rec = reinterpret_cast<const uchar*>(record.constData());
+  if (Fcs16::update(Fcs16::initialFcs, rec, record.size()) != Fcs16::correctFcs) {
+    errorString = QStringLiteral("Damaged record.");
+    return false;
+  }
+
+  encoding = rec[19];
+  const qsizetype payloadStart = HistoryFormat::recordHeaderSize + qFromLittleEndian<quint16>(rec + 20) + qFromLittleEndian<quint16>(rec + 22);
+  payload = record.mid(payloadStart, record.size() - payloadStart - HistoryFormat::recordTrailerSize);
+  return true;
+}
+
+void HistoryStore::addEntry(const Entry& entry) {
+  if (entries.isEmpty() || entries.last().timestampMs <= entry.timestampMs) { // the usual case, tests are appended in time order
+    entries.append(entry);
+    devicePostings[entry.device].append(entries.size() - 1);
+    if (entry.condition >= 0)
+      conditionPostings[entry.condition].append(entries.size() - 1);
+    return;
+  }
+
+  // clock was set back, keep the entries sorted, positions of all the later entries change, so the posting lists are built again
+  const auto pos = std::upper_bound(entries.begin(), entries.end(), entry.timestampMs, [](qint64 t, const Entry& e) { return t < e.timestampMs; });
+  entries.insert(pos, entry);
+  rebuildPostings();
+}
+
+void HistoryStore::rebuildPostings() {
+  for (QVector<qsizetype>& list : devicePostings)
+    list.clear();
+  for (QVector<qsizetype>& list : conditionPostings)
+    list.clear();
+  for (qsizetype i = 0; i < entries.size(); i++) {
+    devicePostings[entries[i].device].append(i);
+    if (entries[i].condition >= 0)
+      conditionPostings[entries[i].condition].append(i);
+  }
+}
+
+int HistoryStore::intern(const QString& name, QStringList& names, QHash<QString, int>& ids, QVector<QVector<qsizetype>>& postings) {
+  const auto it = ids.constFind(name);
+  if (it != ids.constEnd())
+    return *it;
+  names.append(name);
+  postings.append(QVector<qsizetype>());
+  return ids.insert(name, names.size() - 1).value();
+}
@@ -0,0 +1,112 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include <limits>
+
+#include "BattInfo.h"
+#include "Waveform.h"
+#include "WaveformAnalysis.h"
+
+// Records of the history file (little-endian): quint32 record magic, quint32 length of the whole record, qint64 time (ms since epoch),
+// quint8 kind, quint8 SOH, quint8 SOC, quint8 payload encoding, quint16 device name length, quint16 condition length, device name and condition (UTF-8),
+// the payload and quint16 FCS16 of everything before it. Waveform records carry the SOH, SOC and condition of the battery state of the same test,
+// or zeros and an empty condition when it isn't known. Battery state payload: test norm, test result, resistance and voltage,
+// each as quint16 length and UTF-8 text. Waveform payload: quint32 sample interval (us), quint32 sample count, WaveformMetrics as six doubles
+// (only in packedWaveformMetrics records) and the samples, raw or compressed with WaveformCodec, depending on the payload encoding.
+namespace HistoryFormat {
+constexpr char magic[8] = {'K', 'B', 'T', 'H', 'I', 'S', '\r', '\n'};
+constexpr quint32 version = 1;
+constexpr qsizetype headerSize = 16; // magic, quint32 version, quint32 reserved
+constexpr quint32 recordMagic = 0x52544B42; // "KBTR" in the file
+constexpr qsizetype recordHeaderSize = 24;
+constexpr qsizetype recordTrailerSize = 2;
+constexpr uchar rawPayload = 0;
+constexpr uchar packedWaveform = 1;
+constexpr uchar packedWaveformMetrics = 2;
+constexpr qsizetype metricsSize = 6 * 8;
+} // namespace HistoryFormat
+
+// Append-only store of every completed test. Records are never changed once written, so a crash can damage only the last one,
+// which is cut off the next time the file is opened. Damaged data anywhere else is skipped up to the next intact record and left in the file. Indexes by time, device and battery condition are kept in memory and built
+// from the fixed record headers when the file is opened, payloads are read only when a test is requested.
+// Entries are sorted by time, so every posting list of the indexes is sorted by time as well.
+class HistoryStore {
+public:
+  enum class Kind : uchar { BattInfo = 1, Waveform = 2 };
+
+  struct Entry {
+    qint64 timestampMs = 0;
+    qint64 offset = 0; // of the record in the file
+    quint32 length = 0;
+    Kind kind = Kind::BattInfo;
+    uchar soh = 0;
+    uchar soc = 0;
+    int device = -1;    // index to devices()
+    int condition = -1; // index to conditions(), -1 for waveforms without the battery state
+  };
+
+  struct Query {
+    qint64 fromMs = std::numeric_limits<qint64>::min();
+    qint64 toMs = std::numeric_limits<qint64>::max(); // inclusive
+    QString device;                                  // empty matches every device
+    QString condition;                               // empty matches every condition
+    int kinds = 0;                                   // bit mask of Kind values, 0 matches both
+    qsizetype limit = -1;                            // the newest tests are returned when the limit is reached
+  };
+
+public:
+  HistoryStore() = default;
+  ~HistoryStore() { close(); }
+
+  bool open(const QString& fileName); // creates the file if needed
+  bool isOpen() const { return file.isOpen(); }
+  QString fileName() const { return file.fileName(); }
+  void close();
+  QString errorString() const { return error; }
+  qint64 damagedBytes() const { return skippedBytes; } // damaged data skipped when the file was opened, the tests in it are lost
+
+  bool appendBattInfo(const QString& device, qint64 timestampMs, const BattInfo& info);
+  // info is the battery state of the same test, so its waveform is found by condition too, null when there is none
+  bool appendWaveform(const QString& device, qint64 timestampMs, const Waveform& waveform, const WaveformMetrics& metrics, const BattInfo* info);
+
+  qsizetype size() const { return entries.size(); }
+  const Entry& entry(qsizetype index) const { return entries[index]; }
+  const QStringList& devices() const { return deviceNames; }
+  const QStringList& conditions() const { return conditionNames; }
+  QVector<qsizetype> query(const Query& query) const; // indexes of the matching entries, oldest first
+
+  bool readBattInfo(qsizetype index, BattInfo& info);
+  bool readWaveform(qsizetype index, Waveform& waveform, WaveformMetrics* metrics = nullptr); // metrics of older records are computed again
+  // Reads the waveform through another handle of the history file, so tests can be loaded in other threads while new ones are appended,
+  // records are never changed once written. The file must be opened for reading.
+  static bool readWaveform(QFile& file, const Entry& entry, Waveform& waveform, WaveformMetrics* metrics, QString& errorString);
+
+private:
+  bool scan(); // builds the indexes, cuts off a damaged record at the end
+  bool appendRecord(const QString& device, qint64 timestampMs, Kind kind, uchar soh, uchar soc, const QString& condition, const QByteArray& payload,
+                    uchar encoding = HistoryFormat::rawPayload);
+  bool readRecord(qsizetype index, Kind kind, QByteArray& payload, uchar& encoding);
+  static bool readRecord(QFile& file, const Entry& entry, QByteArray& payload, uchar& encoding, QString& errorString);
+  void addEntry(const Entry& entry);
+  void rebuildPostings();
+  static int intern(const QString& name, QStringList& names, QHash<QString, int>& ids, QVector<QVector<qsizetype>>& postings);
+
+private:
+  QFile file;
+  QString error;
+  QVector<Entry> entries;
+  QStringList deviceNames;
+  QStringList conditionNames;
+  QHash<QString, int> deviceIds;
+  QHash<QString, int> conditionIds;
+  QVector<QVector<qsizetype>> devicePostings;    // entries of each device
+  QVector<QVector<qsizetype>> conditionPostings; // entries of each condition
+  qint64 skippedBytes = 0;
+};
+
+#endif // HISTORYSTORE_H
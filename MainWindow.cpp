@@ -1,44 +1,69 @@
 #include "MainWindow.h"
 #include "./ui_MainWindow.h"
 
-MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow), waveformChart(QChart()) {
+MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWindow) {
   ui->setupUi(this);
 
   tabCrankingGrid = new QGridLayout(ui->tabCranking);
-  waveformData = new QLineSeries(&waveformChart);
-  axisX = new QValueAxis(waveformData);
-  axisY = new QValueAxis(waveformData);
 
   QStyle* pbStyle = QStyleFactory::create("Fusion");
   pbStyle->setParent(this);
   ui->pbSoh->setStyle(pbStyle);
   ui->pbSoc->setStyle(pbStyle);
 
-  waveformChart.legend()->hide();
-  waveformChart.setTitle(tr("Battery voltage during cranking"));
-  axisX->setLabelFormat("%.1f");
-  axisX->setTitleText(tr("Time [s]"));
-  axisX->setMinorTickCount(2);
-  axisY->setLabelFormat("%.2f");
-  axisY->setTitleText(tr("Voltage [V]"));
-  axisY->setMinorTickCount(5);
-  waveformChart.addAxis(axisX, Qt::AlignBottom);
-  waveformChart.addAxis(axisY, Qt::AlignLeft);
-  waveformChart.addSeries(waveformData);
-  waveformData->attachAxis(axisX);
-  waveformData->attachAxis(axisY);
-  waveformChartView.setChart(&waveformChart);
-  waveformChartView.setRenderHint(QPainter::Antialiasing);
+  waveformView = new WaveformView(ui->tabCranking);
+  WaveformRenderer::Style chartStyle;
+  chartStyle.title = tr("Battery voltage during cranking");
+  chartStyle.labels = Export::WaveformLabels{tr("Time [s]"), tr("Voltage [V]")};
+  chartStyle.font = font();
+  waveformView->setChartStyle(chartStyle);
+  waveformView->setToolTip(tr("Scroll to zoom, drag to move, double click to show the whole waveform"));
   tabCrankingGrid->setContentsMargins(0, 0, 0, 0);
-  tabCrankingGrid->addWidget(&waveformChartView);
+  tabCrankingGrid->addWidget(waveformView, 0, 0);
+  waveformMetrics = new QLabel(ui->tabCranking);
+  waveformMetrics->setTextInteractionFlags(Qt::TextSelectableByMouse);
+  waveformMetrics->setContentsMargins(6, 6, 6, 6);
+  tabCrankingGrid->addWidget(waveformMetrics, 0, 1, Qt::AlignTop);
+  tabCrankingGrid->setColumnStretch(0, 1);
+  liveTimer = new QTimer(this);
+  liveTimer->setSingleShot(true);
+  liveTimer->setInterval(liveFrameInterval);
+  connect(liveTimer, &QTimer::timeout, this, &MainWindow::updateLiveChart);
 
   statusMsg = new QLabel(tr("Not connected."), ui->statusbar);
   ui->statusbar->addWidget(statusMsg);
-
-  generateFcs16LookupTable(fcs16Lookup);
-
-  if (readSettings()) { // if we have initialized settings, then COM port can be opened
-    if (getSettingsValue(sAutoConnect, bool()).toBool())
+  diagnosticsMsg = new QLabel(ui->statusbar);
+  diagnosticsMsg->setFrameShape(QFrame::StyledPanel);
+  diagnosticsMsg->hide(); // until there is a tester to report on
+  ui->statusbar->addWidget(diagnosticsMsg);
+  diagnosticsTimer = new QTimer(this);
+  diagnosticsTimer->setInterval(diagnosticsInterval);
+  connect(diagnosticsTimer, &QTimer::timeout, this, &MainWindow::updateDiagnostics);
+  deviceSelector = new QComboBox(ui->statusbar);
+  deviceSelector->setToolTip(tr("Tester shown in the window"));
+  deviceSelector->hide(); // shown only when more than one tester is connected
+  ui->statusbar->addPermanentWidget(deviceSelector);
+
+  connect(&sessionManager, &SessionManager::sessionAdded, this, &MainWindow::onSessionAdded);
+  connect(&sessionManager, &SessionManager::aboutToClear, this, &MainWindow::onSessionsCleared);
+  connect(deviceSelector, &QComboBox::currentIndexChanged, this, &MainWindow::onDeviceSelected);
+  openHistory();
+
+  const Settings& settings = Settings::instance();
+  connect(&settings, &Settings::connectionChanged, this, &MainWindow::onConnectionSettingsChanged);
+  ui->updateFirmware->setVisible(settings.connection().firmwareUpdate);
+  ui->liveWaveform->setChecked(settings.display().liveWaveform);
+  connect(ui->liveWaveform, &QAction::toggled, this, [](bool checked) {
+    Settings::Display display = Settings::instance().display();
+    display.liveWaveform = checked;
+    Settings::instance().setDisplay(display);
+  });
+  connect(ui->compareHistory, &QAction::toggled, this, &MainWindow::compareWithHistory);
+  if (settings.isEmpty())
+    QMessageBox::information(this, tr("Information"),
+                             tr("Before connecting to the tester, you must first specify the port for communication.\nConnect the tester to your computer, then choose File->Options menu."));
+  else if (!settings.connection().portName.isEmpty()) { // if we have initialized settings, then COM port can be opened
+    if (settings.connection().autoConnect)
       connectToDevice();
     else
       ui->connectToDevice->setEnabled(true);
@@ -46,12 +71,11 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
 }
 
 MainWindow::~MainWindow() {
-  if (sp != nullptr)
-    delete sp;
+  Settings::instance().sync(); // don't wait for the delayed write
+  disconnect(&sessionManager, nullptr, this, nullptr);
+  sessionManager.clear(); // workers close the serial ports when they're deleted
+  QThreadPool::globalInstance()->waitForDone(); // export jobs are children of the window, let them finish writing their files
   delete tabCrankingGrid;
-  delete waveformData;
-  delete axisX;
-  delete axisY;
   delete ui;
 }
 
@@ -69,28 +93,12 @@ void MainWindow::saveState() {
     return;
   }
 
-  QFile file(fileName);
-  if (!file.open(QFile::WriteOnly | QFile::Text)) {
-    QMessageBox::warning(this, tr("Warning"), tr("Unable to create file.\nNo file operations were performed.\n") + file.errorString());
-    return;
-  }
-
-  QTextStream data(&file);
-  if (fileType == "txt") {
-    data << ui->lSoh->text() << ' ' << ui->pbSoh->value() << '%' << '\n';
-    data << ui->lSoc->text() << ' ' << ui->pbSoc->value() << '%' << '\n';
-    data << removeTextFormatting(ui->lIntRes->text()) << ' ' << ui->lRes->text() << '\n';
-    data << removeTextFormatting(ui->lTestNorm->text()) << ' ' << ui->lTNorm->text() << '\n';
-    data << removeTextFormatting(ui->lTestRes->text()) << ' ' << ui->lTRes->text() << '\n';
-    data << removeTextFormatting(ui->lVoltage->text()) << ' ' << ui->lVol->text() << '\n';
-    data << removeTextFormatting(ui->lOverallCond->text()) << ' ' << ui->lCond->text() << '\n';
-  } else if (fileType == "csv") {
-    data << ui->lSoh->text() << ',' << ui->lSoc->text() << ',' << removeTextFormatting(ui->lIntRes->text()) << ',' << removeTextFormatting(ui->lTestNorm->text()) << ','
-         << removeTextFormatting(ui->lTestRes->text()) << ',' << removeTextFormatting(ui->lVoltage->text()) << ',' << removeTextFormatting(ui->lOverallCond->text()) << '\n';
-    data << ui->pbSoh->value() << '%' << ',' << ui->pbSoc->value() << '%' << ',' << ui->lRes->text() << ',' << ui->lTNorm->text() << ',' << ui->lTRes->text() << ',' << ui->lVol->text() << ','
-         << ui->lCond->text() << '\n';
-  }
-  file.close();
+  startExport(fileName, QFile::Text, [info = currentSession->battInfo(), labels = stateLabels(), asCsv = fileType == "csv"](QIODevice& device, const Export::ProgressCallback&) {
+    QTextStream data(&device);
+    asCsv ? Export::writeStateCsv(data, info, labels) : Export::writeStateTxt(data, info, labels);
+    data.flush();
+    return data.status() == QTextStream::Ok;
+  });
 }
 
 void MainWindow::saveWaveform() {
@@ -109,47 +117,85 @@ void MainWindow::saveWaveform() {
     return;
   }
 
-  QFile file(fileName);
-  bool fileOpenSuccess = false;
-  if (fileType != "csv")
-    fileOpenSuccess = file.open(QFile::WriteOnly);
-  else if (fileType == "csv")
-    fileOpenSuccess = file.open(QFile::WriteOnly | QFile::Text);
-  if (!fileOpenSuccess) {
-    QMessageBox::warning(this, tr("Warning"), tr("Unable to create file.\nNo file operations were performed.\n") + file.errorString());
-    return;
-  }
-
   if (fileType != "csv") {
-    if (!waveformChartView.grab().save(&file)) {
-      QMessageBox::warning(this, tr("Warning"), tr("Unable to save file.\nNo file operations were performed.\n"));
-      return;
-    }
+    // rendered without the chart widget, so the whole job runs in the background and the size doesn't depend on the window
+    startExport(fileName, QIODevice::NotOpen, [waveform = currentSession->waveform(), style = waveformStyle(), format = fileType.toLatin1()](QIODevice& device, const Export::ProgressCallback&) {
+      return WaveformRenderer(style).renderImage(waveform, imageExportSize, imageExportDpi).save(&device, format.constData());
+    });
   } else if (fileType == "csv") {
-    QTextStream data(&file);
-
-    data << axisX->titleText() << ',' << axisY->titleText() << '\n';
-    for (const QPointF& chartPoint : waveformData->points())
-      data << chartPoint.x() << ',' << chartPoint.y() << '\n';
+    const Export::WaveformLabels labels = waveformView->chartStyle().labels;
+    startExport(fileName, QFile::Text, [waveform = currentSession->waveform(), labels](QIODevice& device, const Export::ProgressCallback& progress) {
+      return Export::writeWaveformCsv(device, waveform, labels, progress);
+    });
   }
-  file.close();
 }
 
-void MainWindow::saveBoth() {}
+// QPrinter isn't safe to use outside the GUI thread, but a single test takes at most one page, which is drawn quickly.
+void MainWindow::printReport(bool withState, bool withWaveform) {
+  QPrinter printer(QPrinter::HighResolution);
+  printer.setDocName(tr("Battery test report"));
+  QPrintDialog dlg(&printer, this);
+  if (dlg.exec() != QDialog::Accepted)
+    return;
+
+  ReportWriter report(&printer, reportStyle());
+  if (withState)
+    report.addState(tr("Battery state"), currentSession->battInfo());
+  if (withWaveform)
+    report.addWaveform(waveformView->chartStyle().title, currentSession->waveform());
+  if (!report.finish())
+    QMessageBox::warning(this, tr("Warning"), tr("Unable to print the report."));
+}
+
+void MainWindow::startExport(const QString& fileName, QIODevice::OpenMode mode, ExportJob::Writer writer) {
+  ExportJob* job = new ExportJob(fileName, mode, std::move(writer), this);
+  QProgressDialog* progress = new QProgressDialog(tr("Saving %1...").arg(QFileInfo(fileName).fileName()), tr("Cancel"), 0, 100, this);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  progress->setMinimumDuration(500); // short exports finish without showing anything
+  progress->setAutoReset(false);
+
+  connect(job, &ExportJob::progressChanged, progress, &QProgressDialog::setValue);
+  connect(progress, &QProgressDialog::canceled, job, &ExportJob::cancel);
+  connect(job, &ExportJob::finished, this, [this, job, progress](bool success, const QString& errorString) {
+    progress->close();
+    job->deleteLater();
+    if (!success && !errorString.isEmpty())
+      QMessageBox::warning(this, tr("Warning"), tr("Unable to save file.\nNo file operations were performed.\n") + errorString);
+  });
+  job->start();
+}
+
+void MainWindow::saveBoth() {
+  const QString fileName = QFileDialog::getSaveFileName(this, tr("Save report"), QDir::homePath(), tr("PDF file (*.pdf)"));
+
+  if (fileName.isEmpty()) {
+    QMessageBox::warning(this, tr("Warning"), tr("The file name cannot be empty.\nNo file operations were performed."));
+    return;
+  }
+
+  // the job gets copies of the results, so new tests received while the pages are drawn don't change the report
+  startExport(fileName, QIODevice::NotOpen,
+              [info = currentSession->battInfo(), waveform = currentSession->waveform(), style = reportStyle(), stateHeading = tr("Battery state"),
+               waveformHeading = waveformView->chartStyle().title](QIODevice& device, const Export::ProgressCallback&) {
+                QPdfWriter pdf(&device);
+                ReportWriter::setupPdf(pdf, style.title);
+                ReportWriter report(&pdf, style);
+                report.addState(stateHeading, info);
+                report.addWaveform(waveformHeading, waveform);
+                return report.finish();
+              });
+}
 
-void MainWindow::printState() {}
+void MainWindow::printState() { printReport(true, false); }
 
-void MainWindow::printWaveform() {}
+void MainWindow::printWaveform() { printReport(false, true); }
 
-void MainWindow::printBoth() {}
+void MainWindow::printBoth() { printReport(true, true); }
 
 void MainWindow::showOptions() {
   OptionsDialog* dlg = new OptionsDialog(this);
-  int res = dlg->exec();
+  dlg->exec(); // changes are announced by Settings
   delete dlg;
-
-  if (res == QDialog::Accepted && !ui->disconnectFromDevice->isEnabled())
-    ui->connectToDevice->setEnabled(true);
 }
 
 void MainWindow::showAbout() {
@@ -178,91 +224,182 @@ void MainWindow::showAbout() {
 }
 
 void MainWindow::connectToDevice() {
-  if (getSettingsValue(sPort, QString()).toString().isEmpty()) {
+  const Settings::Connection& connection = Settings::instance().connection();
+  if (connection.portName.isEmpty()) {
     QMessageBox::information(this, tr("Information"),
                              tr("Before connecting to the tester, you must first specify the port for communication.\nConnect the tester to your computer, then choose File->Options menu."));
     statusMsg->setText(tr("Connection unsuccessful."));
     return;
   }
 
-  sp = new SerialPort(getSettingsValue(sPort, QString()).toString(), this);
-  connect(sp, &SerialPort::serialPortDataReceived, this, &MainWindow::onSerialPortDataReceived);
-  connect(sp, &SerialPort::serialPortError, this, &MainWindow::onSerialPortError);
-
-  if (sp->openSerialPort()) {
-    ui->connectToDevice->setEnabled(false);
-    ui->disconnectFromDevice->setEnabled(true);
-    cleanupAfterPacketProcessing();
-    statusMsg->setText(tr("Connected successfully."));
-  } else {
-    sp->closeSerialPort();
-    delete sp;
-    statusMsg->setText(tr("Connection unsuccessfull."));
-  }
+  ui->connectToDevice->setEnabled(false); // until all workers report the result
+  ui->replayCapture->setEnabled(false);
+  sessionManager.clear();
+  const QStringList ports = connection.allPorts();
+  pendingConnections = ports.size();
+  for (const QString& portName : ports)
+    sessionManager.addSession(portName)->open(connection.recordCapture ? newCaptureFileName(portName) : QString());
 }
 
 void MainWindow::disconnectFromDevice() {
-  ui->connectToDevice->setEnabled(true);
-  ui->disconnectFromDevice->setEnabled(false);
-
-  cleanupAfterPacketProcessing();
-  sp->closeSerialPort();
-  delete sp;
+  sessionManager.closeAll(); // also stops the replay, if one is in progress
+  pendingConnections = 0;
+  updateConnectionActions();
   statusMsg->setText(tr("Disconnected from the device."));
 }
 
-void MainWindow::updateFirmware() {}
-
-void MainWindow::onSerialPortDataReceived(const QByteArray& dataBuff) {
-  for (byte b : dataBuff)
-    receivedPacket.append(static_cast<uchar>(b));
-
-  if (!determinePacketType(receivedPacket)) { // if received data is not a full packet or if it is unknown, then we expect receiving the rest of data later
-    if (++receivedDataCheckedTimes == 3)      // if after third time, data that we have is not a valid packet, then discard all data and clear serial port buffer
-      cleanupAfterPacketProcessing();
-  } else {
-    do {
-      switch (receivedPacketType) {
-      case PacketType::BattInfo:
-        displayBattInfo();
-        cleanupAfterPacketProcessing();
-        packetProcessed = true;
-        break;
-      case PacketType::Chart:
-        if (receivedPacket.length() < getPacketLength(receivedPacket)) {
-          receivedPacket.clear();
-          packetProcessed = true;
+void MainWindow::replayCapture() {
+  const QString fileName = QFileDialog::getOpenFileName(this, tr("Replay capture"), QFileInfo(newCaptureFileName()).path(), tr("Capture file (*.kbtcap)"));
+  if (fileName.isEmpty())
+    return;
+
+  const QMessageBox::StandardButton speed =
+      QMessageBox::question(this, tr("Replay capture"), tr("Replay the data with its original timing?\nOtherwise it will be decoded as fast as possible."),
+                            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+  if (speed == QMessageBox::Cancel)
+    return;
+
+  ui->connectToDevice->setEnabled(false); // until the replay finishes
+  ui->replayCapture->setEnabled(false);
+  sessionManager.clear();
+  sessionManager.addSession(QFileInfo(fileName).fileName())->replay(fileName, speed == QMessageBox::Yes);
+}
+
+void MainWindow::saveDiagnostics() {
+  const QString fileName = QFileDialog::getSaveFileName(this, tr("Save diagnostics"), QDir::homePath(), tr("Text file (*.txt)"));
+  if (fileName.isEmpty())
+    return;
+
+  // snapshots are taken now, so the file shows the state from the moment it was requested
+  QByteArray text = "time " + QDateTime::currentDateTime().toString(Qt::ISODateWithMs).toUtf8() + '\n';
+  for (DeviceSession* session : sessionManager.sessions())
+    text += "\n[" + session->name().toUtf8() + "]\n" + session->metrics().snapshot().toText();
+  startExport(fileName, QFile::Text, [text](QIODevice& device, const Export::ProgressCallback&) { return device.write(text) == text.size(); });
+}
+
+void MainWindow::updateFirmware() {
+  if (!Settings::instance().connection().firmwareUpdate || currentSession == nullptr || !currentSession->isActive() || currentSession->isReplay())
+    return;
+  const QString fileName = QFileDialog::getOpenFileName(this, tr("Update firmware"), QDir::homePath(), tr("Firmware image (*.bin);;All files (*)"));
+  if (fileName.isEmpty())
+    return;
+  if (QMessageBox::question(this, tr("Firmware update"),
+                            tr("Send %1 to %2?\nThe update speaks the protocol of the tester emulator, a real tester doesn't understand it. Don't disconnect the tester until the update finishes.")
+                                .arg(QFileInfo(fileName).fileName(), currentSession->name()))
+      != QMessageBox::Yes)
+    return;
+
+  DeviceSession* session = currentSession;
+  QProgressDialog* progress = new QProgressDialog(tr("Updating the firmware of %1...").arg(session->name()), tr("Cancel"), 0, 100, this);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  progress->setWindowModality(Qt::WindowModal); // the tester can't be disconnected or switched while its flash is written
+  progress->setMinimumDuration(0);
+  progress->setAutoReset(false);
+
+  connect(session, &DeviceSession::firmwareUpdateProgress, progress, [progress](qint64 doneBytes, qint64 totalBytes) { progress->setValue(static_cast<int>(doneBytes * 100 / totalBytes)); });
+  connect(progress, &QProgressDialog::canceled, session, &DeviceSession::cancelFirmwareUpdate);
+  connect(session, &QObject::destroyed, progress, &QProgressDialog::close);
+  connect(
+      session, &DeviceSession::firmwareUpdateFinished, progress,
+      [this, progress](bool success, const QString& errorString) {
+        progress->close();
+        if (success) {
+          statusMsg->setText(tr("Firmware updated."));
+          QMessageBox::information(this, tr("Information"), tr("The firmware was updated successfully."));
+        } else if (errorString.isEmpty()) {
+          statusMsg->setText(tr("Firmware update cancelled."));
         } else {
-          ushort processedBytes = prepareChart();
-          receivedPacket.erase(receivedPacket.cbegin(), receivedPacket.cbegin() + processedBytes);
-          sp->removeDataFromBufferStart(processedBytes);
-          if (!receivedPacket.length()) {
-            cleanupAfterPacketProcessing();
-            packetProcessed = true;
-          } else
-            receivedPacketType = PacketType::Unknown;
+          statusMsg->setText(tr("Firmware update failed."));
+          QMessageBox::warning(this, tr("Warning"), tr("Unable to update the firmware.\n") + errorString);
         }
-        break;
-      case PacketType::ChartDisplay:
-        displayChart();
-        cleanupAfterPacketProcessing();
-        packetProcessed = true;
-        break;
-      case PacketType::Unknown:
-        if (!determinePacketType(receivedPacket))
-          packetProcessed = true;
-        break;
-      }
-    } while (!packetProcessed);
-    packetProcessed = false;
-  }
+      },
+      Qt::SingleShotConnection);
+  session->updateFirmware(fileName);
+}
+
+void MainWindow::onSessionAdded(DeviceSession* session) {
+  connect(session, &DeviceSession::opened, this, [this, session](bool success) { onSessionOpened(session, success); });
+  connect(session, &DeviceSession::errorOccurred, this, [this, session](const QSerialPort::SerialPortError& error) { onSessionError(session, error); });
+  connect(session, &DeviceSession::captureError, this, [this, session](const QString& errorString) { onCaptureError(session, errorString); });
+  connect(session, &DeviceSession::replayStarted, this, [this, session](bool success, const QString& errorString) { onReplayStarted(session, success, errorString); });
+  connect(session, &DeviceSession::replayFinished, this, [this, session]() { onReplayFinished(session); });
+  connect(session, &DeviceSession::battInfoReceived, this, [this, session]() {
+    recordTest(session, HistoryStore::Kind::BattInfo);
+    if (session == currentSession) {
+      const qint64 start = PipelineMetrics::now();
+      displayBattInfo(session->battInfo());
+      session->metrics().renderLatency.record(PipelineMetrics::now() - start);
+    }
+  });
+  connect(session, &DeviceSession::waveformReceived, this, [this, session]() {
+    recordTest(session, HistoryStore::Kind::Waveform);
+    if (session == currentSession) {
+      const qint64 start = PipelineMetrics::now();
+      displayChart(session->waveform(), session->waveformMetrics());
+      session->metrics().renderLatency.record(PipelineMetrics::now() - start);
+    }
+  });
+  connect(session, &DeviceSession::waveformProgress, this, [this, session]() {
+    if (session == currentSession && ui->liveWaveform->isChecked() && !liveTimer->isActive())
+      liveTimer->start(); // samples received until it fires are drawn together
+  });
+
+  deviceSelector->addItem(session->name()); // the first one is selected automatically
+  deviceSelector->setVisible(deviceSelector->count() > 1);
+  ui->saveDiagnostics->setEnabled(true);
+  diagnosticsTimer->start();
+}
+
+void MainWindow::onSessionsCleared() {
+  currentSession = nullptr;
+  ui->updateFirmware->setEnabled(false);
+  const QSignalBlocker blocker(deviceSelector);
+  deviceSelector->clear();
+  deviceSelector->hide();
+  ui->saveDiagnostics->setEnabled(false);
+  diagnosticsTimer->stop();
+  clearDeviceView();
+}
+
+void MainWindow::onDeviceSelected(int index) {
+  const QVector<DeviceSession*>& sessions = sessionManager.sessions();
+  currentSession = (index >= 0 && index < sessions.size()) ? sessions[index] : nullptr;
+  updateConnectionActions();
+
+  clearDeviceView();
+  updateDiagnostics();
+  if (currentSession == nullptr)
+    return;
+  if (currentSession->hasBattInfo())
+    displayBattInfo(currentSession->battInfo());
+  if (!currentSession->waveform().isEmpty())
+    displayChart(currentSession->waveform(), currentSession->waveformMetrics());
+}
+
+void MainWindow::onConnectionSettingsChanged(const Settings::Connection& connection) {
+  if (!ui->disconnectFromDevice->isEnabled()) // new port is used with the next connection
+    ui->connectToDevice->setEnabled(!connection.portName.isEmpty());
+  ui->updateFirmware->setVisible(connection.firmwareUpdate);
+  ui->updateFirmware->setEnabled(connection.firmwareUpdate && currentSession != nullptr && currentSession->isActive() && !currentSession->isReplay());
 }
 
-void MainWindow::onSerialPortError(const QSerialPort::SerialPortError& error) {
+void MainWindow::onSessionOpened(DeviceSession* session, bool success) {
+  pendingConnections = qMax(pendingConnections - 1, 0);
+  updateConnectionActions();
+  if (sessionManager.sessions().size() == 1)
+    statusMsg->setText(success ? tr("Connected successfully.") : tr("Connection unsuccessfull."));
+  else
+    statusMsg->setText((success ? tr("Connected to %1.") : tr("Connection to %1 unsuccessful.")).arg(session->name()));
+}
+
+void MainWindow::onSessionError(DeviceSession* session, const QSerialPort::SerialPortError& error) {
   if (error == QSerialPort::NoError) // if for some reason we get this error, then we can safely ignore it
     return;
 
-  disconnectFromDevice();
+  session->close(); // other testers keep working
+  updateConnectionActions();
+  if (!sessionManager.isAnyActive())
+    statusMsg->setText(tr("Disconnected from the device."));
 
   QString message;
   switch (error) {
@@ -300,174 +437,230 @@ void MainWindow::onSerialPortError(const QSerialPort::SerialPortError& error) {
     break;
   }
 
+  if (sessionManager.sessions().size() > 1)
+    message = session->name() + ": " + message;
   QMessageBox::critical(this, tr("Error - serial port"), message);
 }
 
-void MainWindow::generateFcs16LookupTable(ushort (&arrayToPopulate)[256]) {
-  const ushort P = 0x8408;
-
-  for (ushort b = 0; b < 256; b++) {
-    ushort v = b;
-    for (uchar i = 8; i > 0; i--) {
-      v = (v & 1) ? (v >> 1) ^ P : v >> 1;
-    }
-    arrayToPopulate[b] = v & 0xFFFF;
-  }
+void MainWindow::onCaptureError(DeviceSession* session, const QString& errorString) {
+  QMessageBox::warning(this, tr("Warning"), tr("Unable to record the data received from %1.\n").arg(session->name()) + errorString);
 }
 
-QPair<ushort, ushort> MainWindow::calculatePacketChecksums(const QVector<uchar>& packetToCheck) const {
-  uint packetLen = getPacketLength(packetToCheck);
-  ushort currentFcs = 0xFFFF;
-  uint checksumKonnwei = 0;
-
-  for (uint i = 0; i < packetLen; i++) {
-    ushort lastFcs = currentFcs;
-    currentFcs = (currentFcs >> 8) ^ fcs16Lookup[(currentFcs ^ packetToCheck[i]) & 0xFF];
-    if (i < packetLen - 2)
-      checksumKonnwei = (lastFcs ^ packetToCheck[i]) << 16 | currentFcs;
+void MainWindow::onReplayStarted(DeviceSession* session, bool success, const QString& errorString) {
+  Q_UNUSED(session);
+  updateConnectionActions();
+  if (success) {
+    statusMsg->setText(tr("Replaying capture."));
+    return;
   }
-  return QPair<ushort, ushort>{currentFcs, (checksumKonnwei ^ 0xFFFF) & 0xFFFF};
-}
-
-bool MainWindow::checkIfPacketChecksumsOk(const QVector<uchar>& packetToCheck) const {
-  const ushort correctFcs = 0xF0B8;
-  uint packetLen = getPacketLength(packetToCheck);
-  QPair<ushort, ushort> checksums = calculatePacketChecksums(packetToCheck);
-  ushort receivedChecksum = packetToCheck[packetLen - 1] << 8 | packetToCheck[packetLen - 2];
-  // check if standard data checksum (first) is correct and if konnwei checksum (second) is correct
-  if (checksums.first == correctFcs && receivedChecksum == checksums.second)
-    return true;
-  return false;
-}
 
-bool MainWindow::checkIfPacketCorrect(const QVector<uchar>& packetToCheck) const {
-  if (this->receivedPacketType == PacketType::Unknown)
-    return false;
-  if (this->receivedPacketType == PacketType::BattInfo)
-    if (!checkIfPacketHaveTrailer(packetToCheck))
-      return false;
-  if (this->receivedPacketType == PacketType::Chart || this->receivedPacketType == PacketType::ChartDisplay)
-    if (!checkIfPacketHaveTrailer(packetToCheck) || !checkIfPacketChecksumsOk(packetToCheck))
-      return false;
-  return true;
+  statusMsg->setText(tr("Replay unsuccessful."));
+  QMessageBox::warning(this, tr("Warning"), tr("Unable to open the capture file.\n") + errorString);
 }
 
-bool MainWindow::checkIfPacketHaveTrailer(const QVector<uchar>& packetToCheck) const {
-  if (packetToCheck.end()[-1] == 0x0A && packetToCheck.end()[-2] == 0x0D)
-    return true;
-  return false;
+void MainWindow::onReplayFinished(DeviceSession* session) {
+  Q_UNUSED(session);
+  updateConnectionActions();
+  statusMsg->setText(tr("Replay finished."));
 }
 
-ushort MainWindow::getPacketLength(const QVector<uchar>& packetToCheck) const {
-  return ((packetToCheck[3] << 8) | packetToCheck[2]) - 2; // omit new line chars in packet len
+void MainWindow::updateConnectionActions() {
+  const bool active = sessionManager.isAnyActive();
+  ui->disconnectFromDevice->setEnabled(active); // stops the replay as well
+  ui->connectToDevice->setEnabled(!active && !pendingConnections && !Settings::instance().connection().portName.isEmpty());
+  ui->replayCapture->setEnabled(!active && !pendingConnections);
+  ui->updateFirmware->setEnabled(Settings::instance().connection().firmwareUpdate && currentSession != nullptr && currentSession->isActive() && !currentSession->isReplay());
 }
 
-ushort MainWindow::getPacketEncoding(const QVector<uchar>& packetToCheck) const { return (packetToCheck[6] << 8) | packetToCheck[5]; }
-
-bool MainWindow::isPacketBattInfo(const QVector<uchar>& packetToCheck) {
-  const QVector<uchar> header{0x0, 0x24, 0x24, 0xFF, 0xFE};
-
-  if (packetToCheck.length() < 9)
-    return false;
-
-  for (uchar i = 0; i < header.length(); i++) {
-    if (packetToCheck[i] != header[i])
-      return false;
+void MainWindow::updateDiagnostics() {
+  if (currentSession == nullptr) {
+    diagnosticsMsg->hide();
+    return;
   }
-  this->receivedPacketType = PacketType::BattInfo;
-  return true;
-}
-
-bool MainWindow::isPacketChart(const QVector<uchar>& packetToCheck) {
-  const QVector<uchar> header{0x24, 0x24, 0, 0, 0xFF, 0x01};
-
-  if (packetToCheck.length() < 10)
-    return false;
 
-  for (uchar i = 0; i < header.length(); i++) {
-    if (i == 2 || i == 3) // second and third byte are packet length, so ignore them
-      continue;
-    if (packetToCheck[i] != header[i])
-      return false;
-  }
-  this->receivedPacketType = PacketType::Chart;
-  return true;
+  using Counter = PipelineMetrics::Counter;
+  const PipelineMetrics::Snapshot m = currentSession->metrics().snapshot();
+  const quint64 frames = m.value(Counter::BattInfoFrames) + m.value(Counter::ChartFrames) + m.value(Counter::ChartDisplayFrames);
+  const quint64 errors = m.value(Counter::ChecksumFailures) + m.value(Counter::Resyncs);
+  diagnosticsMsg->setText(tr("%1 received, %2 packets, %3 errors").arg(locale().formattedDataSize(m.value(Counter::BytesReceived))).arg(frames).arg(errors));
+
+  const auto latency = [](const LatencyHistogram::Snapshot& l) {
+    return tr("%1 / %2 / %3 ms").arg(l.p50 / 1e6, 0, 'f', 3).arg(l.p99 / 1e6, 0, 'f', 3).arg(l.max / 1e6, 0, 'f', 3);
+  };
+  diagnosticsMsg->setToolTip(QStringLiteral("<table cellspacing=\"2\">")
+                             + tr("<tr><td>Battery state packets:</td><td>%1</td></tr>").arg(m.value(Counter::BattInfoFrames))
+                             + tr("<tr><td>Waveform packets:</td><td>%1</td></tr>").arg(m.value(Counter::ChartFrames))
+                             + tr("<tr><td>Chart display packets:</td><td>%1</td></tr>").arg(m.value(Counter::ChartDisplayFrames))
+                             + tr("<tr><td>Checksum failures:</td><td>%1</td></tr>").arg(m.value(Counter::ChecksumFailures))
+                             + tr("<tr><td>Resynchronisations:</td><td>%1 (%2 bytes skipped)</td></tr>").arg(m.value(Counter::Resyncs)).arg(m.value(Counter::DroppedBytes))
+                             + tr("<tr><td>Queue depth:</td><td>%1 (max %2, full %3 times)</td></tr>").arg(m.queueDepth).arg(m.maxQueueDepth).arg(m.value(Counter::QueueFull))
+                             + tr("<tr><td>Decode latency (p50 / p99 / max):</td><td>%1</td></tr>").arg(latency(m.decodeLatency))
+                             + tr("<tr><td>Delivery latency (p50 / p99 / max):</td><td>%1</td></tr>").arg(latency(m.deliveryLatency))
+                             + tr("<tr><td>Render latency (p50 / p99 / max):</td><td>%1</td></tr>").arg(latency(m.renderLatency)) + QStringLiteral("</table>"));
+  diagnosticsMsg->show();
 }
 
-bool MainWindow::isPacketChartDisplay(const QVector<uchar>& packetToCheck) {
-  const QVector<uchar> header{0x24, 0x24, 0x0A, 0x00, 0xFF, 0x02};
-
-  if (packetToCheck.length() < 10)
-    return false;
-
-  for (uchar i = 0; i < header.length(); i++) {
-    if (packetToCheck[i] != header[i])
-      return false;
-  }
-  this->receivedPacketType = PacketType::ChartDisplay;
-  return true;
+QString MainWindow::newCaptureFileName(const QString& portName) const {
+  const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/captures");
+  QDir().mkpath(dir);
+  QString fileName = dir + QDateTime::currentDateTime().toString(QStringLiteral("/yyyyMMdd-HHmmss"));
+  if (!portName.isEmpty()) // several testers are recorded at the same time
+    fileName += '-' + QFileInfo(portName).fileName();
+  return fileName + QStringLiteral(".kbtcap");
 }
 
-bool MainWindow::determinePacketType(const QVector<uchar>& packetToCheck) {
-  if (!isPacketBattInfo(packetToCheck))
-    if (!isPacketChart(packetToCheck))
-      if (!isPacketChartDisplay(packetToCheck))
-        return false; // unknown packet type
-  if (!checkIfPacketCorrect(packetToCheck))
-    return false; // packet is not correct
-  return true;    // packet type has been determined
+void MainWindow::openHistory() {
+  const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+  if (!QDir().mkpath(dir) || !history.open(dir + QStringLiteral("/history.kbthist")))
+    QMessageBox::warning(this, tr("Warning"), tr("Unable to open the test history, received tests won't be saved.\n") + history.errorString());
+  else if (history.damagedBytes() > 0)
+    statusMsg->setText(tr("A damaged part of the test history was skipped, the other tests are available."));
+  ui->compareHistory->setEnabled(history.isOpen());
 }
 
-bool MainWindow::readSettings() {
-  QSettings settings(sSettingsFileName, QSettings::IniFormat, this);
-  bool res = false;
-
-  if (!settings.allKeys().size()) {
-    QMessageBox::information(this, tr("Information"),
-                             tr("Before connecting to the tester, you must first specify the port for communication.\nConnect the tester to your computer, then choose File->Options menu."));
-    return false;
-  }
+// Results of replayed captures were already recorded when they were received.
+void MainWindow::recordTest(DeviceSession* session, HistoryStore::Kind kind) {
+  if (!history.isOpen() || session->isReplay())
+    return;
 
-  settings.beginGroup(sGroup);
-  if (!settings.value(sPort, QString()).toString().isEmpty())
-    res = true; // we have a COM port specified in settings
-  settings.endGroup();
-  return res;
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  // the tester sends the battery state of a test before its waveform, so the waveform is stored with the condition of the same test
+  const bool success = kind == HistoryStore::Kind::BattInfo ? history.appendBattInfo(session->name(), now, session->battInfo())
+                                                            : history.appendWaveform(session->name(), now, session->waveform(), session->waveformMetrics(),
+                                                                                     session->hasBattInfo() ? &session->battInfo() : nullptr);
+  if (!success)
+    statusMsg->setText(tr("Unable to save the test in the history: %1").arg(history.errorString()));
 }
 
-const QVariant MainWindow::getSettingsValue(const QString& settingName, const QVariant& valueType) {
-  QSettings settings(sSettingsFileName, QSettings::IniFormat, this);
-  settings.beginGroup(sGroup);
-  return settings.value(settingName, valueType);
+void MainWindow::updateLiveChart() {
+  if (currentSession == nullptr || currentSession->receivingWaveform().isEmpty())
+    return; // chart was completed or the session closed in the meantime
+
+  const Trace::Span span("MainWindow::updateLiveChart");
+  waveformView->updateLive(currentSession->receivingWaveform()); // only the new samples are added, the axes grow with them
+  if (!waveformView->isShowingOverlay())
+    waveformMetrics->setText(tr("Receiving the waveform..."));
 }
 
-ushort MainWindow::prepareChart() {
-  receivedData = {receivedPacket.begin(), receivedPacket.begin() + getPacketLength(receivedPacket) + 2};
-  static float timeVal = 0.0;
+// Tests are chosen here, loading them, the alignment and the band are done by a job in the thread pool.
+void MainWindow::compareWithHistory(bool checked) {
+  if (!checked) {
+    if (overlayJob)
+      overlayJob->cancel(); // finishes on its own and is ignored then
+    overlayJob = nullptr;
+    waveformView->clearOverlay();
+    if (currentSession && !currentSession->waveform().isEmpty())
+      displayChart(currentSession->waveform(), currentSession->waveformMetrics());
+    else
+      waveformMetrics->clear();
+    return;
+  }
 
-  if (chartReceivedAndDisplayed) { // if we are adding data to the current chart, then don't reset current time stamp, otherwise set timestamp to 0
-    chartReceivedAndDisplayed = false;
-    timeVal = 0.0;
-    waveformData->clear();
+  QDialog dlg(this);
+  dlg.setWindowTitle(tr("Compare with history"));
+  QFormLayout* form = new QFormLayout(&dlg);
+  QComboBox* device = new QComboBox(&dlg);
+  device->addItem(tr("All testers"));
+  device->addItems(history.devices());
+  if (currentSession)
+    device->setCurrentIndex(qMax(device->findText(currentSession->name()), 0));
+  QSpinBox* count = new QSpinBox(&dlg);
+  count->setRange(2, maxOverlayTests);
+  count->setValue(defaultOverlayTests);
+  QCheckBox* band = new QCheckBox(tr("Mean and 10th to 90th percentile"), &dlg);
+  band->setChecked(true);
+  QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dlg);
+  connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+  form->addRow(tr("Tester:"), device);
+  form->addRow(tr("Newest tests:"), count);
+  form->addRow(band);
+  form->addRow(buttons);
+  if (dlg.exec() != QDialog::Accepted) {
+    ui->compareHistory->setChecked(false);
+    return;
   }
 
-  for (int i = 6; i < getPacketLength(receivedData) - 2; i += 2) {
-    waveformData->append(timeVal, ((receivedData[i + 1] << 8) | receivedData[i]) / 10.0);
-    timeVal += 0.0125;
+  HistoryStore::Query query;
+  query.device = device->currentIndex() > 0 ? device->currentText() : QString();
+  query.kinds = int(HistoryStore::Kind::Waveform);
+  query.limit = count->value();
+  QVector<OverlayJob::Test> tests;
+  for (const qsizetype index : history.query(query))
+    tests.append(OverlayJob::Test{history.entry(index), history.devices().value(history.entry(index).device)});
+  if (tests.isEmpty()) {
+    QMessageBox::information(this, tr("Information"), tr("There are no waveforms in the history of the chosen tester."));
+    ui->compareHistory->setChecked(false);
+    return;
   }
 
-  return receivedData.length();
+  WaveformOverlay::Parameters parameters;
+  parameters.band = band->isChecked();
+  OverlayJob* job = new OverlayJob(history.fileName(), tests, parameters, this);
+  QProgressDialog* progress = new QProgressDialog(tr("Loading %n test(s)...", nullptr, tests.size()), tr("Cancel"), 0, 100, this);
+  progress->setAttribute(Qt::WA_DeleteOnClose);
+  progress->setMinimumDuration(500); // a few tests are loaded without showing anything
+  progress->setAutoReset(false);
+
+  connect(job, &OverlayJob::progressChanged, progress, &QProgressDialog::setValue);
+  connect(progress, &QProgressDialog::canceled, job, &OverlayJob::cancel);
+  connect(job, &OverlayJob::finished, this, [this, job, progress](bool success, const QString& errorString) {
+    progress->close();
+    job->deleteLater();
+    if (overlayJob != job)
+      return; // replaced by a newer comparison, which reports its own result
+    overlayJob = nullptr;
+    if (success && ui->compareHistory->isChecked()) {
+      waveformView->setOverlay(job->takeOverlay());
+      displayOverlay(job->damagedTests());
+      return;
+    }
+    ui->compareHistory->setChecked(false);
+    if (!errorString.isEmpty())
+      QMessageBox::warning(this, tr("Warning"), tr("Unable to read the tests from the history.\n") + errorString);
+  });
+  if (overlayJob)
+    overlayJob->cancel(); // the previous one finishes on its own
+  overlayJob = job;
+  job->start();
 }
 
-void MainWindow::displayChart() {
-  const QList<QPointF>& chartPoints = waveformData->points();
-  const auto minMaxX = std::minmax_element(chartPoints.cbegin(), chartPoints.cend(), [](const QPointF& l, const QPointF& r) { return l.x() < r.x(); });
-  const auto minMaxY = std::minmax_element(chartPoints.cbegin(), chartPoints.cend(), [](const QPointF& l, const QPointF& r) { return l.y() < r.y(); });
-
-  axisX->setRange(minMaxX.first->x(), minMaxX.second->x());
-  axisY->setRange(std::floor(minMaxY.first->y()), std::ceil(minMaxY.second->y()));
+void MainWindow::displayOverlay(qsizetype damagedTests) {
+  const WaveformOverlay& overlay = waveformView->waveformOverlay();
+  const WaveformRenderer::Style& style = waveformView->chartStyle();
+  const auto dateTime = [this](qint64 timestampMs) { return locale().toString(QDateTime::fromMSecsSinceEpoch(timestampMs), QLocale::ShortFormat); };
+  const auto legend = [](const QColor& color, const QString& text) {
+    return QStringLiteral("<tr><td><span style=\"color:%1\">&#9632;</span></td><td>%2</td></tr>").arg(color.name(QColor::HexArgb), text);
+  };
+
+  QString text = QStringLiteral("<table cellspacing=\"4\">") + tr("<tr><td>Tests:</td><td>%1</td></tr>").arg(overlay.size())
+                 + tr("<tr><td>Oldest:</td><td>%1</td></tr>").arg(dateTime(overlay.members().first().timestampMs))
+                 + tr("<tr><td>Newest:</td><td>%1</td></tr>").arg(dateTime(overlay.members().last().timestampMs));
+  if (damagedTests)
+    text += tr("<tr><td>Damaged, left out:</td><td>%1</td></tr>").arg(damagedTests);
+  text += QStringLiteral("</table><p>") + tr("Time 0 s is the start of cranking.") + QStringLiteral("</p><table cellspacing=\"4\">") + legend(style.line, tr("Newest test"));
+  if (overlay.hasBand())
+    text += legend(style.mean, tr("Mean")) + legend(style.band, tr("10th to 90th percentile"));
+  waveformMetrics->setText(text + QStringLiteral("</table>"));
+}
 
-  chartReceivedAndDisplayed = true;
+void MainWindow::displayChart(const Waveform& waveform, const WaveformMetrics& metrics) {
+  const Trace::Span span("MainWindow::displayChart");
+  liveTimer->stop();
+  waveformView->setWaveform(waveform);
+
+  if (!waveformView->isShowingOverlay()) { // otherwise the summary of the overlay stays beside it
+    if (metrics.valid)
+      waveformMetrics->setText(QStringLiteral("<table cellspacing=\"4\">")
+                               + tr("<tr><td>Minimum voltage:</td><td>%1 V</td></tr>").arg(metrics.minVoltage, 0, 'f', 2)
+                               + tr("<tr><td>Dip time:</td><td>%1 s</td></tr>").arg(metrics.dipTime, 0, 'f', 3)
+                               + tr("<tr><td>Recovery slope:</td><td>%1 V/s</td></tr>").arg(metrics.recoverySlope, 0, 'f', 2)
+                               + tr("<tr><td>Time under %1 V:</td><td>%2 s</td></tr>").arg(WaveformAnalysis::Parameters().thresholdVoltage, 0, 'f', 1).arg(metrics.timeUnderThreshold, 0, 'f', 3)
+                               + tr("<tr><td>RMS ripple:</td><td>%1 V</td></tr>").arg(metrics.rippleRms, 0, 'f', 3)
+                               + tr("<tr><td>Settle voltage:</td><td>%1 V</td></tr>").arg(metrics.settleVoltage, 0, 'f', 2) + QStringLiteral("</table>"));
+    else
+      waveformMetrics->clear();
+  }
 
   ui->saveWaveform->setEnabled(true);
   ui->printWaveform->setEnabled(true);
@@ -477,51 +670,59 @@ void MainWindow::displayChart() {
   }
 }
 
-void MainWindow::displayBattInfo() {
-  receivedData = {receivedPacket.begin() + 7, receivedPacket.end() - 2}; // discard header and codepage info from the begining and \r\n from the end
-  QString battInfo = QString::fromUtf8(receivedData);
-  QStringList splittedInfo = battInfo.split("\r\n");
-
-  QString sohValue(splittedInfo[0].section('=', 1, 1).trimmed());
-  sohValue.chop(1); // remove % sign
-  ui->pbSoh->setValue(sohValue.toInt());
-
-  QString socValue(splittedInfo[1].section('=', 1, 1).trimmed());
-  socValue.chop(1); // remove % sign
-  ui->pbSoc->setValue(socValue.toInt());
-
-  QString testNorm(splittedInfo[2].section('=', 0, 0).trimmed() + '-' + splittedInfo[3].section('=', 1, 1).trimmed());
-  ui->lTNorm->setText(testNorm);
-
-  QString testRes(splittedInfo[2].section('=', 1, 1).trimmed());
-  ui->lTRes->setText(testRes);
-
-  QString resValue(splittedInfo[4].section('=', 1, 1).trimmed());
-  resValue.chop(1);     // remove placeholder for omega sign
-  resValue += "\u03A9"; // add omega sign
-  ui->lRes->setText(resValue);
-
-  QString battVoltage(splittedInfo[5].section('=', 1, 1).trimmed());
-  ui->lVol->setText(battVoltage);
-
-  QString battCond(splittedInfo[6].trimmed());
-  ui->lCond->setText(battCond);
+void MainWindow::displayBattInfo(const BattInfo& info) {
+  const Trace::Span span("MainWindow::displayBattInfo");
+  ui->pbSoh->setValue(info.soh);
+  ui->pbSoc->setValue(info.soc);
+  ui->lTNorm->setText(info.testNorm);
+  ui->lTRes->setText(info.testResult);
+  ui->lRes->setText(info.resistance);
+  ui->lVol->setText(info.voltage);
+  ui->lCond->setText(info.condition);
 
   ui->saveState->setEnabled(true);
   ui->printState->setEnabled(true);
-  if (chartReceivedAndDisplayed) {
+  if (ui->saveWaveform->isEnabled()) {
     ui->saveBoth->setEnabled(true);
     ui->printBoth->setEnabled(true);
   }
 }
 
-void MainWindow::cleanupAfterPacketProcessing() {
-  receivedPacketType = PacketType::Unknown;
-  receivedDataCheckedTimes = 0;
-  receivedPacket.clear();
-  receivedData.clear();
-  sp->clearDataBuffer();
-  sp->clearSerialPortDataBuffer();
+void MainWindow::clearDeviceView() {
+  liveTimer->stop();
+  waveformView->clear();
+  if (!waveformView->isShowingOverlay())
+    waveformMetrics->clear();
+  ui->pbSoh->setValue(0);
+  ui->pbSoc->setValue(0);
+  for (QLabel* label : {ui->lTNorm, ui->lTRes, ui->lRes, ui->lVol, ui->lCond})
+    label->setText(tr("N/A"));
+
+  for (QAction* action : {ui->saveState, ui->printState, ui->saveWaveform, ui->printWaveform, ui->saveBoth, ui->printBoth})
+    action->setEnabled(false);
 }
 
 QString MainWindow::removeTextFormatting(const QString& richText) const { return QTextDocumentFragment::fromHtml(richText).toPlainText().simplified(); }
+
+Export::StateLabels MainWindow::stateLabels() const {
+  Export::StateLabels labels;
+  labels.soh = ui->lSoh->text();
+  labels.soc = ui->lSoc->text();
+  labels.resistance = removeTextFormatting(ui->lIntRes->text());
+  labels.testNorm = removeTextFormatting(ui->lTestNorm->text());
+  labels.testResult = removeTextFormatting(ui->lTestRes->text());
+  labels.voltage = removeTextFormatting(ui->lVoltage->text());
+  labels.condition = removeTextFormatting(ui->lOverallCond->text());
+  return labels;
+}
+
+ReportWriter::Style MainWindow::reportStyle() const {
+  ReportWriter::Style style;
+  style.title = tr("Battery test report");
+  style.pageNumber = tr("Page %1");
+  style.stateLabels = stateLabels();
+  style.waveform = waveformStyle();
+  return style;
+}
+
+WaveformRenderer::Style MainWindow::waveformStyle() const { return waveformView->chartStyle(); }
@@ -2,10 +2,23 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QtCharts>
-
+#include <QPrintDialog>
+#include <QPrinter>
+#include <QtWidgets>
+
+#include "BattInfo.h"
+#include "Export.h"
+#include "ExportJob.h"
+#include "HistoryStore.h"
 #include "OptionsDialog.h"
-#include "SerialPort.h"
+#include "OverlayJob.h"
+#include "ReportWriter.h"
+#include "SessionManager.h"
+#include "Settings.h"
+#include "Trace.h"
+#include "Waveform.h"
+#include "WaveformRenderer.h"
+#include "WaveformView.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -35,56 +48,64 @@ private slots:
 
   void connectToDevice();
   void disconnectFromDevice();
+  void replayCapture();
+  void saveDiagnostics();
   void updateFirmware();
 
-  void onSerialPortDataReceived(const QByteArray& dataBuff);
-  void onSerialPortError(const QSerialPort::SerialPortError& error);
+  void onSessionAdded(DeviceSession* session);
+  void onSessionsCleared();
+  void onDeviceSelected(int index);
+  void onConnectionSettingsChanged(const Settings::Connection& connection);
 
 private:
-  void generateFcs16LookupTable(ushort (&arrayToPopulate)[256]);
-
-  QPair<ushort, ushort> calculatePacketChecksums(const QVector<uchar>& packetToCheck) const;
-  bool checkIfPacketChecksumsOk(const QVector<uchar>& packetToCheck) const;
-  bool checkIfPacketCorrect(const QVector<uchar>& packetToCheck) const;
-  bool checkIfPacketHaveTrailer(const QVector<uchar>& packetToCheck) const;
-
-  ushort getPacketLength(const QVector<uchar>& packetToCheck) const;
-  ushort getPacketEncoding(const QVector<uchar>& packetToCheck) const;
-
-  bool isPacketBattInfo(const QVector<uchar>& packetToCheck);
-  bool isPacketChart(const QVector<uchar>& packetToCheck);
-  bool isPacketChartDisplay(const QVector<uchar>& packetToCheck);
-  bool determinePacketType(const QVector<uchar>& packetToCheck);
-
-  bool readSettings();
-  const QVariant getSettingsValue(const QString& settingName, const QVariant& valueType);
-  ushort prepareChart();
-  void displayChart();
-  void displayBattInfo();
-  void cleanupAfterPacketProcessing();
+  void onSessionOpened(DeviceSession* session, bool success);
+  void onSessionError(DeviceSession* session, const QSerialPort::SerialPortError& error);
+  void onCaptureError(DeviceSession* session, const QString& errorString);
+  void onReplayStarted(DeviceSession* session, bool success, const QString& errorString);
+  void onReplayFinished(DeviceSession* session);
+  void updateConnectionActions();
+  void updateDiagnostics();
+  void updateLiveChart();
+  void compareWithHistory(bool checked);
+  void displayOverlay(qsizetype damagedTests);
+
+  QString newCaptureFileName(const QString& portName = QString()) const;
+  void openHistory();
+  void recordTest(DeviceSession* session, HistoryStore::Kind kind);
+  void startExport(const QString& fileName, QIODevice::OpenMode mode, ExportJob::Writer writer);
+  void printReport(bool withState, bool withWaveform);
+  void displayChart(const Waveform& waveform, const WaveformMetrics& metrics);
+  void displayBattInfo(const BattInfo& info);
+  void clearDeviceView();
 
   QString removeTextFormatting(const QString& richText) const;
+  Export::StateLabels stateLabels() const;           // translated captions from the UI
+  WaveformRenderer::Style waveformStyle() const;     // exported chart looks like the one in the window
+  ReportWriter::Style reportStyle() const;
 
 private:
-  enum class PacketType : uchar { Unknown, BattInfo, Chart, ChartDisplay };
+  static constexpr QSize imageExportSize{1600, 900}; // independent of the window size
+  static constexpr qreal imageExportDpi = 144.0;
+  static constexpr int diagnosticsInterval = 1000; // ms
+  static constexpr int liveFrameInterval = 33;     // ms, the live chart is redrawn at most 30 times per second
+  static constexpr int defaultOverlayTests = 50;
+  static constexpr int maxOverlayTests = 1000;
 
-  ushort fcs16Lookup[256];
-  QVector<uchar> receivedPacket;
-  PacketType receivedPacketType = PacketType::Unknown;
-  QVector<uchar> receivedData;
+private:
+  SessionManager sessionManager;           // serial port reading and packet decoding run in its threads, so a busy UI can't delay them
+  DeviceSession* currentSession = nullptr; // tester shown in the window, source of exports
+  QComboBox* deviceSelector = nullptr;
+  int pendingConnections = 0;              // ports that haven't reported the result of opening yet
+  HistoryStore history;                    // every test received from the testers
+  OverlayJob* overlayJob = nullptr;        // loading of the tests to compare, if one is in progress
 
   QGridLayout* tabCrankingGrid = nullptr;
-  QLineSeries* waveformData = nullptr;
-  QChart waveformChart;
-  QValueAxis* axisX = nullptr;
-  QValueAxis* axisY = nullptr;
-  QChartView waveformChartView;
-  bool chartReceivedAndDisplayed = false;
-
-  SerialPort* sp = nullptr;
-  QLabel* statusMsg = nullptr;
+  WaveformView* waveformView = nullptr;
+  QLabel* waveformMetrics = nullptr; // results of the analysis, beside the chart
+  QTimer* liveTimer = nullptr;       // coalesces the updates of the chart being received into one redraw per frame
 
-  ushort receivedDataCheckedTimes = 0; // if received data doesn't match to any type of packet, then check the buffer again
-  bool packetProcessed = false;        // if data was processed, set to true to clear buffers
+  QLabel* statusMsg = nullptr;
+  QLabel* diagnosticsMsg = nullptr; // pipeline metrics of the tester shown in the window, beside the status
+  QTimer* diagnosticsTimer = nullptr;
 };
 #endif // MAINWINDOW_H
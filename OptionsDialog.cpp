@@ -5,54 +5,55 @@ OptionsDialog::OptionsDialog(QWidget* parent) : QDialog(parent), ui(new Ui::Opti
   ui->setupUi(this);
 
   const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
-  if (ports.count()) {
-    for (const QSerialPortInfo& inf : ports)
-      ui->cbbComPort->addItem(QString("%1 (%2)").arg(inf.portName(), inf.description()));
+  for (const QSerialPortInfo& inf : ports)
+    ui->cbbComPort->addItem(QString("%1 (%2)").arg(inf.portName(), inf.description()));
 
-    ui->cbbComPort->setEnabled(true);
-    ui->cbAutoConnect->setEnabled(true);
-  }
+  // port that isn't listed, like a pseudo-terminal of the tester emulator, can be given by its path
+  ui->cbbComPort->setEnabled(true);
+  ui->cbAutoConnect->setEnabled(true);
   readSettingsFile();
 }
 
 OptionsDialog::~OptionsDialog() { delete ui; }
 
 bool OptionsDialog::saveSettingsFile() {
-  QSettings settings(sSettingsFileName, QSettings::IniFormat, this);
-
-  if (!ui->cbbComPort->count())
-    return false; // if we don't have any COM ports, then don't go further
+  if (ui->cbbComPort->currentText().isEmpty())
+    return false; // if we don't have any COM port, then don't go further
 
   QString portDesc = ui->cbbComPort->currentText().section('(', 1, 1);
   portDesc.chop(1); // remove last char ')' from port description
 
-  settings.beginGroup(sGroup);
-  settings.setValue(sPort, ui->cbbComPort->currentText().section(' ', 0, 0));
-  settings.setValue(sPortDesc, portDesc);
-  settings.setValue(sAutoConnect, ui->cbAutoConnect->isChecked());
-  settings.endGroup();
+  Settings::Connection connection;
+  connection.portName = ui->cbbComPort->currentText().section(' ', 0, 0);
+  connection.portDescription = portDesc;
+  connection.autoConnect = ui->cbAutoConnect->isChecked();
+  connection.recordCapture = ui->cbRecordCapture->isChecked();
+  connection.firmwareUpdate = ui->cbFirmwareUpdate->isChecked();
+  for (const QString& port : ui->leAdditionalPorts->text().split(',', Qt::SkipEmptyParts))
+    if (!port.trimmed().isEmpty() && port.trimmed() != connection.portName && !connection.additionalPorts.contains(port.trimmed()))
+      connection.additionalPorts.append(port.trimmed());
+  Settings::instance().setConnection(connection); // written to the file in the background
 
   return true;
 }
 
 bool OptionsDialog::readSettingsFile() {
-  QSettings settings(sSettingsFileName, QSettings::IniFormat, this);
-
-  if (!settings.allKeys().size())
+  const Settings& settings = Settings::instance();
+  if (settings.isEmpty())
     return false; // do nothing if there is no settings file
 
-  if (!ui->cbbComPort->count())
-    return false; // if we don't have any COM ports, then don't go further
-
-  settings.beginGroup(sGroup);
+  const Settings::Connection& connection = settings.connection();
+  ui->cbbComPort->setEditText(connection.portName); // used if the port isn't listed
   for (ushort i = 0; i < ui->cbbComPort->count(); i++) {
-    if (ui->cbbComPort->currentText().section(' ', 0, 0) == settings.value(sPort, QString()).toString()) {
+    if (ui->cbbComPort->itemText(i).section(' ', 0, 0) == connection.portName) {
       ui->cbbComPort->setCurrentIndex(i);
       break;
     }
   }
-  settings.value(sAutoConnect, bool()).toBool() ? ui->cbAutoConnect->setChecked(true) : ui->cbAutoConnect->setChecked(false);
-  settings.endGroup();
+  ui->cbAutoConnect->setChecked(connection.autoConnect);
+  ui->cbRecordCapture->setChecked(connection.recordCapture);
+  ui->cbFirmwareUpdate->setChecked(connection.firmwareUpdate);
+  ui->leAdditionalPorts->setText(connection.additionalPorts.join(", "));
 
   return true;
 }
@@ -3,9 +3,8 @@
 
 #include <QDialog>
 #include <QSerialPortInfo>
-#include <QSettings>
 
-#include "SettingsNames.h"
+#include "Settings.h"
 
 namespace Ui {
 class OptionsDialog;
@@ -0,0 +1,61 @@
+#include "OverlayJob.h"
+
+#include <QThreadPool>
+
+#include "Trace.h"
+
+namespace {
+constexpr int loadingPercent = 80; // reading and decoding takes most of the time, the band the rest
+}
+
+OverlayJob::OverlayJob(const QString& historyFileName, const QVector<Test>& tests, const WaveformOverlay::Parameters& parameters, QObject* parent)
+    : QObject{parent}, fileName(historyFileName), tests(tests), parameters(parameters) {}
+
+void OverlayJob::start() {
+  QThreadPool::globalInstance()->start([this] { run(); });
+}
+
+void OverlayJob::cancel() { canceled.store(true, std::memory_order_relaxed); }
+
+bool OverlayJob::reportProgress(qsizetype done, qsizetype total) {
+  const int percent = total ? int(done * 100 / total) : 100;
+  if (percent != lastPercent) { // signals are queued to the GUI thread, so don't send one for every test
+    lastPercent = percent;
+    emit progressChanged(percent);
+  }
+  return !canceled.load(std::memory_order_relaxed);
+}
+
+void OverlayJob::run() {
+  Trace::Span span("OverlayJob::run");
+  span.setArg("tests", tests.size());
+
+  QFile file(fileName);
+  if (!file.open(QFile::ReadOnly)) {
+    emit finished(false, file.errorString());
+    return;
+  }
+
+  Waveform waveform;
+  QString errorString;
+  for (qsizetype i = 0; i < tests.size(); i++) {
+    if (!reportProgress(i * loadingPercent, tests.size() * 100)) {
+      emit finished(false, QString());
+      return;
+    }
+    if (HistoryStore::readWaveform(file, tests[i].entry, waveform, nullptr, errorString))
+      overlay.add(tests[i].entry.timestampMs, tests[i].device, waveform, parameters);
+    else
+      damaged++;
+  }
+  file.close();
+  if (overlay.isEmpty() && damaged) { // nothing to show, errorString is the reason of the last failure
+    emit finished(false, errorString);
+    return;
+  }
+
+  const bool success = overlay.computeBand(parameters, [this](qsizetype done, qsizetype total) {
+    return reportProgress(loadingPercent * total + done * (100 - loadingPercent), total * 100);
+  });
+  emit finished(success, QString()); // the job can be deleted as soon as this is delivered, so it must be the last thing done here
+}
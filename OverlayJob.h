@@ -0,0 +1,47 @@
+#ifndef OVERLAYJOB_H
+#define OVERLAYJOB_H
+
+#include <QObject>
+
+#include <atomic>
+
+#include "HistoryStore.h"
+#include "WaveformOverlay.h"
+
+// Loads tests from the history and builds their overlay in a thread of the global pool, so decoding, alignment and the band
+// never block the window. The history file is read through its own handle, new tests can be recorded in the meantime.
+class OverlayJob : public QObject {
+  Q_OBJECT
+public:
+  struct Test {
+    HistoryStore::Entry entry;
+    QString device;
+  };
+
+  OverlayJob(const QString& historyFileName, const QVector<Test>& tests, const WaveformOverlay::Parameters& parameters, QObject* parent = nullptr);
+
+public:
+  void start();
+  void cancel(); // can be called from any thread, the job still finishes with finished(false)
+  WaveformOverlay takeOverlay() { return std::move(overlay); } // after finished(true) was received
+  qsizetype damagedTests() const { return damaged; }          // tests that couldn't be read and were left out
+
+signals:
+  void progressChanged(int percent);
+  void finished(bool success, const QString& errorString); // errorString is empty when the job was cancelled
+
+private:
+  void run();
+  bool reportProgress(qsizetype done, qsizetype total);
+
+private:
+  const QString fileName;
+  const QVector<Test> tests;
+  const WaveformOverlay::Parameters parameters;
+  std::atomic_bool canceled{false};
+  WaveformOverlay overlay; // used only by the pool thread until the job finishes
+  qsizetype damaged = 0;
+  int lastPercent = -1;
+};
+
+#endif // OVERLAYJOB_H
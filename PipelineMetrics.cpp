@@ -0,0 +1,91 @@
+#include "PipelineMetrics.h"
+
+#include <QtAlgorithms>
+
+#include <chrono>
+
+namespace {
+int bucketOf(quint64 ns) { return qMin(64 - int(qCountLeadingZeroBits(ns)), LatencyHistogram::bucketCount - 1); } // number of significant bits
+
+// upper bound of the bucket in which the given fraction of all values is reached
+qint64 percentile(const std::array<quint64, LatencyHistogram::bucketCount>& counts, quint64 total, double fraction) {
+  const quint64 rank = static_cast<quint64>(total * fraction);
+  quint64 seen = 0;
+  for (int i = 0; i < LatencyHistogram::bucketCount; i++) {
+    seen += counts[i];
+    if (seen > rank)
+      return (qint64(1) << i) - 1;
+  }
+  return 0;
+}
+
+void appendLatency(QByteArray& text, const char* name, const LatencyHistogram::Snapshot& latency) {
+  const QByteArray prefix = QByteArray(name) + '.';
+  text += prefix + "count " + QByteArray::number(latency.count) + '\n';
+  text += prefix + "mean_ns " + QByteArray::number(latency.mean) + '\n';
+  text += prefix + "p50_ns " + QByteArray::number(latency.p50) + '\n';
+  text += prefix + "p99_ns " + QByteArray::number(latency.p99) + '\n';
+  text += prefix + "max_ns " + QByteArray::number(latency.max) + '\n';
+}
+} // namespace
+
+void LatencyHistogram::record(qint64 ns) {
+  if (ns < 0)
+    ns = 0;
+  buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(ns, std::memory_order_relaxed);
+  qint64 prev = maximum.load(std::memory_order_relaxed);
+  while (ns > prev && !maximum.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) // usually a single load, the maximum rarely changes
+    ;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  std::array<quint64, bucketCount> counts;
+  Snapshot res;
+  for (int i = 0; i < bucketCount; i++) {
+    counts[i] = buckets[i].load(std::memory_order_relaxed);
+    res.count += counts[i];
+  }
+  if (!res.count)
+    return res;
+
+  res.mean = static_cast<qint64>(sum.load(std::memory_order_relaxed) / res.count);
+  res.p50 = percentile(counts, res.count, 0.5);
+  res.p99 = percentile(counts, res.count, 0.99);
+  res.max = maximum.load(std::memory_order_relaxed);
+  return res;
+}
+
+qint64 PipelineMetrics::now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+void PipelineMetrics::setQueueDepth(qsizetype depth) {
+  queueDepth.store(depth, std::memory_order_relaxed);
+  if (depth > maxQueueDepth.load(std::memory_order_relaxed)) // only the producer writes it
+    maxQueueDepth.store(depth, std::memory_order_relaxed);
+}
+
+PipelineMetrics::Snapshot PipelineMetrics::snapshot() const {
+  Snapshot res;
+  for (int i = 0; i < counterCount; i++)
+    res.counters[i] = counters[i].load(std::memory_order_relaxed);
+  res.queueDepth = queueDepth.load(std::memory_order_relaxed);
+  res.maxQueueDepth = maxQueueDepth.load(std::memory_order_relaxed);
+  res.decodeLatency = decodeLatency.snapshot();
+  res.deliveryLatency = deliveryLatency.snapshot();
+  res.renderLatency = renderLatency.snapshot();
+  return res;
+}
+
+QByteArray PipelineMetrics::Snapshot::toText() const {
+  static constexpr const char* counterNames[counterCount] = {"bytes_received", "battinfo_frames", "chart_frames", "chart_display_frames",
+                                                             "checksum_failures", "resyncs", "dropped_bytes", "queue_full"};
+  QByteArray text;
+  for (int i = 0; i < counterCount; i++)
+    text += QByteArray(counterNames[i]) + ' ' + QByteArray::number(counters[i]) + '\n';
+  text += "queue_depth " + QByteArray::number(queueDepth) + '\n';
+  text += "queue_depth_max " + QByteArray::number(maxQueueDepth) + '\n';
+  appendLatency(text, "decode_latency", decodeLatency);
+  appendLatency(text, "delivery_latency", deliveryLatency);
+  appendLatency(text, "render_latency", renderLatency);
+  return text;
+}
@@ -0,0 +1,79 @@
+#ifndef PIPELINEMETRICS_H
+#define PIPELINEMETRICS_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+
+// Histogram of latencies in nanoseconds with power of two buckets. record() is a few relaxed atomic additions, so it can be called from
+// any thread on every frame, a snapshot taken while it is being updated may be off by the latencies recorded in the meantime.
+class LatencyHistogram {
+public:
+  static constexpr int bucketCount = 40; // bucket n holds latencies below 2^n ns, the last one everything from 2^38 ns (4.6 minutes) up
+
+  struct Snapshot {
+    quint64 count = 0;
+    qint64 mean = 0; // all values in ns, percentiles are upper bounds of their buckets
+    qint64 p50 = 0;
+    qint64 p99 = 0;
+    qint64 max = 0;
+  };
+
+  void record(qint64 ns);
+  Snapshot snapshot() const;
+
+private:
+  std::array<std::atomic<quint64>, bucketCount> buckets{};
+  std::atomic<quint64> sum{0};
+  std::atomic<qint64> maximum{0};
+};
+
+// Counters and latencies of the receive path of one tester. The worker thread updates the decoding side, the GUI thread the delivery
+// and rendering side, without locks, so the instrumentation stays enabled all the time. Both sides are kept in separate cache lines.
+class PipelineMetrics {
+public:
+  enum class Counter : uchar {
+    BytesReceived,
+    BattInfoFrames,
+    ChartFrames,
+    ChartDisplayFrames,
+    ChecksumFailures,
+    Resyncs,      // the decoder skipped data that wasn't a valid packet
+    DroppedBytes, // bytes skipped by the resyncs
+    QueueFull,    // times the queue filled up and the worker had to hold frames back, because the GUI thread didn't keep up
+  };
+  static constexpr int counterCount = int(Counter::QueueFull) + 1;
+
+  struct Snapshot {
+    std::array<quint64, counterCount> counters{};
+    qsizetype queueDepth = 0; // frames waiting for the GUI thread when the last frame was queued
+    qsizetype maxQueueDepth = 0;
+    LatencyHistogram::Snapshot decodeLatency;   // from receiving the last byte of a packet to queueing its frame
+    LatencyHistogram::Snapshot deliveryLatency; // from queueing a frame to taking it out of the queue in the GUI thread
+    LatencyHistogram::Snapshot renderLatency;   // time needed to show the results in the window
+
+    quint64 value(Counter counter) const { return counters[int(counter)]; }
+    QByteArray toText() const; // one "name value" line per metric, for diagnostic dumps
+  };
+
+  static qint64 now(); // monotonic time in ns, used for all latencies
+
+  void add(Counter counter, quint64 n = 1) { counters[int(counter)].fetch_add(n, std::memory_order_relaxed); }
+  void setQueueDepth(qsizetype depth);
+  Snapshot snapshot() const;
+
+  // producer (worker thread) side
+  LatencyHistogram decodeLatency;
+  // consumer (GUI thread) side
+  alignas(64) LatencyHistogram deliveryLatency;
+  LatencyHistogram renderLatency;
+
+private:
+  alignas(64) std::array<std::atomic<quint64>, counterCount> counters{};
+  std::atomic<qsizetype> queueDepth{0};
+  std::atomic<qsizetype> maxQueueDepth{0};
+};
+
+#endif // PIPELINEMETRICS_H
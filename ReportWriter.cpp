@@ -0,0 +1,128 @@
+#include "ReportWriter.h"
+
+#include <iterator>
+#include <utility>
+
+namespace {
+constexpr qreal pointsPerInch = 72.0;
+constexpr qreal sectionGap = 14.0; // in points
+} // namespace
+
+ReportWriter::ReportWriter(QPagedPaintDevice* device, const Style& style) : device(device), reportStyle(style), renderer(style.waveform) {}
+
+ReportWriter::~ReportWriter() { finish(); }
+
+void ReportWriter::addState(const QString& heading, const BattInfo& info) {
+  const QFontMetricsF fm(reportStyle.font, device);
+  const Export::StateLabels& labels = reportStyle.stateLabels;
+  const std::pair<QString, QString> rows[] = {{labels.soh, QString::number(info.soh) + '%'},
+                                              {labels.soc, QString::number(info.soc) + '%'},
+                                              {labels.resistance, info.resistance},
+                                              {labels.testNorm, info.testNorm},
+                                              {labels.testResult, info.testResult},
+                                              {labels.voltage, info.voltage},
+                                              {labels.condition, info.condition}};
+  const qreal rowHeight = fm.height() * 1.4;
+  if (!reserve(fm.height() * 2.0 + std::size(rows) * rowHeight))
+    return;
+  drawHeading(heading);
+
+  qreal labelWidth = 0.0;
+  for (const auto& row : rows)
+    labelWidth = qMax(labelWidth, fm.horizontalAdvance(row.first));
+
+  const qreal width = device->width();
+  painter.setFont(reportStyle.font);
+  for (const auto& row : rows) {
+    painter.setPen(QPen(QColor(0xD0, 0xD0, 0xD0), 0.5 * pt));
+    painter.drawLine(QPointF(0.0, y + rowHeight), QPointF(width, y + rowHeight));
+    painter.setPen(Qt::black);
+    painter.drawText(QRectF(0.0, y, labelWidth, rowHeight), Qt::AlignLeft | Qt::AlignVCenter, row.first);
+    painter.drawText(QRectF(labelWidth + 12.0 * pt, y, width - labelWidth - 12.0 * pt, rowHeight), Qt::AlignLeft | Qt::AlignVCenter, row.second);
+    y += rowHeight;
+  }
+  y += sectionGap * pt;
+}
+
+void ReportWriter::addWaveform(const QString& heading, const Waveform& waveform) {
+  const QFontMetricsF fm(reportStyle.font, device);
+  const qreal height = reportStyle.waveformHeight * pt;
+  if (!reserve(fm.height() * 2.0 + height))
+    return;
+  drawHeading(heading);
+
+  renderer.render(painter, QRectF(0.0, y, device->width(), height), waveform);
+  y += height + sectionGap * pt;
+}
+
+bool ReportWriter::finish() {
+  if (painter.isActive()) {
+    drawPageNumber();
+    painter.end();
+  }
+  return !failed;
+}
+
+void ReportWriter::setupPdf(QPdfWriter& pdf, const QString& title) {
+  pdf.setTitle(title);
+  pdf.setCreator(QStringLiteral("KBTinfo"));
+  pdf.setResolution(300); // coordinates of the vectors, doesn't affect the size of the file
+  pdf.setPageSize(QPageSize(QPageSize::A4));
+  pdf.setPageMargins(QMarginsF(15.0, 15.0, 15.0, 15.0), QPageLayout::Millimeter);
+}
+
+bool ReportWriter::reserve(qreal height) {
+  if (failed)
+    return false;
+
+  if (!painter.isActive()) {
+    if (!painter.begin(device)) {
+      failed = true;
+      return false;
+    }
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    pt = device->logicalDpiY() / pointsPerInch;
+    pages = 1;
+
+    QFont titleFont = reportStyle.font;
+    if (titleFont.pointSizeF() > 0.0)
+      titleFont.setPointSizeF(titleFont.pointSizeF() * 1.6);
+    titleFont.setBold(true);
+    const QFontMetricsF fm(titleFont, device);
+    painter.setFont(titleFont);
+    painter.setPen(Qt::black);
+    painter.drawText(QRectF(0.0, 0.0, device->width(), fm.height()), Qt::AlignLeft | Qt::AlignVCenter, reportStyle.title);
+    y = fm.height() + sectionGap * pt;
+  }
+
+  const qreal bottom = device->height() - QFontMetricsF(reportStyle.font, device).height() * 2.0; // space for the page number
+  if (y + height <= bottom || y == 0.0) // a block higher than the whole page is drawn anyway and clipped by the device
+    return true;
+
+  drawPageNumber();
+  if (!device->newPage()) {
+    failed = true;
+    return false;
+  }
+  pages++;
+  y = 0.0;
+  return true;
+}
+
+void ReportWriter::drawHeading(const QString& heading) {
+  QFont headingFont = reportStyle.font;
+  headingFont.setBold(true);
+  const QFontMetricsF fm(headingFont, device);
+  painter.setFont(headingFont);
+  painter.setPen(Qt::black);
+  painter.drawText(QRectF(0.0, y, device->width(), fm.height() * 2.0), Qt::AlignLeft | Qt::AlignVCenter, heading);
+  y += fm.height() * 2.0;
+}
+
+void ReportWriter::drawPageNumber() {
+  const QFontMetricsF fm(reportStyle.font, device);
+  painter.setFont(reportStyle.font);
+  painter.setPen(Qt::black);
+  painter.drawText(QRectF(0.0, device->height() - fm.height(), device->width(), fm.height()), Qt::AlignHCenter | Qt::AlignBottom, reportStyle.pageNumber.arg(pages));
+}
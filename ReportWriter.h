@@ -0,0 +1,57 @@
+#ifndef REPORTWRITER_H
+#define REPORTWRITER_H
+
+#include <QPagedPaintDevice>
+#include <QPdfWriter>
+#include <QPainter>
+
+#include "BattInfo.h"
+#include "Export.h"
+#include "Waveform.h"
+#include "WaveformRenderer.h"
+
+// Lays out battery states and waveforms one after another on the pages of a QPdfWriter or a QPrinter.
+// Every section is drawn as soon as it's added and nothing is kept afterwards, pages are written out by the device
+// when a new one is started, so reports of any number of tests take the same amount of memory.
+// Charts are drawn with QPainter, so they stay vectors in PDF files.
+class ReportWriter {
+public:
+  struct Style {
+    QString title = QStringLiteral("Battery test report"); // printed on the top of the first page
+    QString pageNumber = QStringLiteral("Page %1");
+    Export::StateLabels stateLabels;
+    WaveformRenderer::Style waveform;
+    QFont font = QFont(QString(), 10);
+    qreal waveformHeight = 250.0; // in points
+  };
+
+  explicit ReportWriter(QPagedPaintDevice* device, const Style& style = Style()); // device must outlive the writer
+  ~ReportWriter();                                                                   // calls finish()
+
+public:
+  bool isActive() const { return painter.isActive(); }
+  int pageCount() const { return pages; }
+
+  void addState(const QString& heading, const BattInfo& info);
+  void addWaveform(const QString& heading, const Waveform& waveform);
+  bool finish(); // ends the last page, returns false if the device couldn't be written
+
+  static void setupPdf(QPdfWriter& pdf, const QString& title); // page size, margins and metadata used by all the reports
+
+private:
+  bool reserve(qreal height); // starts the first page or a new one if the block doesn't fit on the current page
+  void drawHeading(const QString& heading);
+  void drawPageNumber();
+
+private:
+  QPagedPaintDevice* device;
+  const Style reportStyle;
+  const WaveformRenderer renderer;
+  QPainter painter;
+  qreal pt = 1.0;   // device units in one point
+  qreal y = 0.0;    // where the next block starts on the current page
+  int pages = 0;
+  bool failed = false;
+};
+
+#endif // REPORTWRITER_H
@@ -0,0 +1,82 @@
+#include "RingBuffer.h"
+
+RingBuffer::View RingBuffer::View::mid(qsizetype pos, qsizetype len) const {
+  const qsizetype total = length();
+  if (pos > total)
+    pos = total;
+  if (len < 0 || pos + len > total)
+    len = total - pos;
+
+  if (pos >= firstPart.length) // everything is in the second span
+    return View{Span{secondPart.data + (pos - firstPart.length), len}, Span{}};
+
+  const qsizetype inFirst = qMin(len, firstPart.length - pos);
+  return View{Span{firstPart.data + pos, inFirst}, Span{secondPart.data, len - inFirst}};
+}
+
+QByteArray RingBuffer::View::toByteArray() const {
+  QByteArray res;
+  res.reserve(length());
+  res.append(reinterpret_cast<const char*>(firstPart.data), firstPart.length);
+  res.append(reinterpret_cast<const char*>(secondPart.data), secondPart.length);
+  return res;
+}
+
+RingBuffer::RingBuffer(qsizetype minCapacity) {
+  qsizetype cap = 1;
+  while (cap < minCapacity)
+    cap <<= 1;
+  storage.resize(cap);
+  mask = cap - 1;
+}
+
+RingBuffer::View RingBuffer::view() const {
+  const qsizetype len = length();
+  const Span first = spanAt(readPos, len);
+  return View{first, spanAt(readPos + first.length, len - first.length)};
+}
+
+RingBuffer::View RingBuffer::lastWritten(qsizetype howManyBytes) const {
+  if (howManyBytes > length())
+    howManyBytes = length();
+  return view().mid(length() - howManyBytes);
+}
+
+RingBuffer::WritableSpan RingBuffer::writableSpan() {
+  const qsizetype start = writePos & mask;
+  return WritableSpan{storage.data() + start, qMin(freeSpace(), capacity() - start)};
+}
+
+void RingBuffer::commit(qsizetype howManyBytes) {
+  Q_ASSERT(howManyBytes <= freeSpace());
+  writePos += howManyBytes;
+  bytesWritten += howManyBytes;
+}
+
+qsizetype RingBuffer::write(const uchar* data, qsizetype len) {
+  qsizetype written = 0;
+  while (written < len && freeSpace()) { // at most two iterations, the second one happens when we wrap around the end of the storage
+    const WritableSpan dst = writableSpan();
+    const qsizetype chunk = qMin(dst.length, len - written);
+    memcpy(dst.data, data + written, chunk);
+    commit(chunk);
+    written += chunk;
+  }
+  return written;
+}
+
+qsizetype RingBuffer::consume(qsizetype howManyBytes) {
+  if (howManyBytes > length())
+    howManyBytes = length();
+  readPos += howManyBytes;
+  if (readPos == writePos) // when the buffer is empty, start from the beginning of the storage to keep the data contiguous as long as possible
+    readPos = writePos = 0;
+  return howManyBytes;
+}
+
+void RingBuffer::clear() { readPos = writePos = 0; }
+
+RingBuffer::Span RingBuffer::spanAt(quint64 pos, qsizetype len) const {
+  const qsizetype start = pos & mask;
+  return Span{storage.constData() + start, qMin(len, capacity() - start)};
+}
@@ -0,0 +1,73 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QByteArray>
+#include <QVector>
+
+// Fixed-capacity byte ring buffer. Data is written once into the storage and then handed to consumers as views,
+// so consuming data from the front of the buffer is O(1) and doesn't move any bytes.
+class RingBuffer {
+public:
+  // contiguous part of the buffered data, valid until the data is consumed or the buffer is cleared
+  struct Span {
+    const uchar* data = nullptr;
+    qsizetype length = 0;
+  };
+
+  // contiguous free space at the write position
+  struct WritableSpan {
+    uchar* data = nullptr;
+    qsizetype length = 0;
+  };
+
+  // read-only view of the buffered data, made of two spans when the data wraps around the end of the storage
+  class View {
+  public:
+    View() = default;
+    View(const Span& first, const Span& second) : firstPart(first), secondPart(second) {}
+
+    qsizetype length() const { return firstPart.length + secondPart.length; }
+    bool isEmpty() const { return !length(); }
+    uchar operator[](qsizetype i) const { return i < firstPart.length ? firstPart.data[i] : secondPart.data[i - firstPart.length]; }
+    const Span& first() const { return firstPart; }
+    const Span& second() const { return secondPart; }
+
+    View mid(qsizetype pos, qsizetype len = -1) const; // returns a view of len bytes starting at pos (or everything after pos if len is negative)
+    QByteArray toByteArray() const;                    // copies the viewed bytes, use only when contiguous data is really needed
+
+  private:
+    Span firstPart;
+    Span secondPart;
+  };
+
+public:
+  explicit RingBuffer(qsizetype minCapacity); // capacity is rounded up to the nearest power of two
+
+  qsizetype capacity() const { return storage.size(); }
+  qsizetype length() const { return static_cast<qsizetype>(writePos - readPos); }
+  qsizetype freeSpace() const { return capacity() - length(); }
+  bool isEmpty() const { return writePos == readPos; }
+
+  View view() const;                            // all data that wasn't consumed yet
+  View lastWritten(qsizetype howManyBytes) const; // the most recently written bytes, e.g. the ones added by the last write
+
+  WritableSpan writableSpan(); // contiguous free space at the write position, fill it and then call commit()
+  void commit(qsizetype howManyBytes);
+  qsizetype write(const uchar* data, qsizetype len); // copies as much data as fits and returns the number of bytes written
+  qsizetype consume(qsizetype howManyBytes);         // drops bytes from the front of the buffer and returns the number of bytes dropped
+  void clear();
+
+  quint64 totalWritten() const { return bytesWritten; } // every byte is copied into the storage exactly once, so this is also the number of copied bytes
+
+private:
+  Span spanAt(quint64 pos, qsizetype len) const;
+
+private:
+  QVector<uchar> storage;
+  qsizetype mask = 0;
+  quint64 readPos = 0; // positions grow monotonically, index into the storage is (pos & mask)
+  quint64 writePos = 0;
+  quint64 bytesWritten = 0;
+};
+
+#endif // RINGBUFFER_H
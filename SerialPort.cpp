@@ -1,8 +1,12 @@
 #include "SerialPort.h"
 
+#include "Trace.h"
+
 SerialPort::SerialPort(const QString& portName, QObject* parent) : QObject{parent}, spName(portName) {}
 
 SerialPort::~SerialPort() {
+  if (sp == nullptr)
+    return;
   if (sp->isOpen())
     closeSerialPort();
   delete sp;
@@ -13,6 +17,7 @@ bool SerialPort::openSerialPort() {
     if (sp->isOpen())
       closeSerialPort();
     delete sp;
+    sp = nullptr;
   }
 
   const QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
@@ -25,14 +30,16 @@ bool SerialPort::openSerialPort() {
     }
   }
 
-  if (spInfo.isNull())
-    return false; // if we can't find the serial port selected by the user then we can't open it
-  else {
+  if (spInfo.isNull()) {
+    if (spName.isEmpty())
+      return false; // if we can't find the serial port selected by the user then we can't open it
+    sp = new QSerialPort(spName, this); // not listed, but it can be a path to a device, e.g. pseudo-terminal of the tester emulator
+  } else
     sp = new QSerialPort(spInfo, this);
-    connect(sp, &QSerialPort::readyRead, this, &SerialPort::spDataReceived);
-    connect(sp, &QSerialPort::errorOccurred, this, &SerialPort::spError);
-    sp->setBaudRate(QSerialPort::Baud115200);
-  }
+
+  connect(sp, &QSerialPort::readyRead, this, &SerialPort::spDataReceived);
+  connect(sp, &QSerialPort::errorOccurred, this, &SerialPort::spError);
+  sp->setBaudRate(QSerialPort::Baud115200);
   return sp->open(QIODeviceBase::ReadWrite);
 }
 
@@ -43,11 +50,13 @@ bool SerialPort::writeDataToSerialPort(const QByteArray& dataToWrite) {
   return true;
 }
 
-ushort SerialPort::removeDataFromBufferStart(const ushort& howManyBytes) {
+qsizetype SerialPort::removeDataFromBufferStart(const qsizetype& howManyBytes) {
   if (howManyBytes > spData.length())
     return spData.length(); // if we want to remove more than buffer holds, then do nothing
 
-  spData.erase(spData.cbegin(), spData.cbegin() + howManyBytes);
+  spData.consume(howManyBytes);
+  if (sp != nullptr && sp->bytesAvailable()) // our buffer was full, so fetch the rest of the data once the current slot returns
+    QMetaObject::invokeMethod(this, &SerialPort::spDataReceived, Qt::QueuedConnection);
 
   return spData.length();
 }
@@ -56,11 +65,33 @@ void SerialPort::clearDataBuffer() { spData.clear(); }
 
 bool SerialPort::clearSerialPortDataBuffer(const QSerialPort::Directions& dir) { return sp->clear(dir); }
 
-void SerialPort::closeSerialPort() { sp->close(); }
+void SerialPort::closeSerialPort() {
+  if (sp != nullptr)
+    sp->close();
+}
+
+qsizetype SerialPort::feedData(const uchar* data, qsizetype len) {
+  const qsizetype written = spData.write(data, len);
+  if (written)
+    emit serialPortDataReceived(spData.lastWritten(written));
+  return written;
+}
 
 void SerialPort::spDataReceived() {
-  spData.append(sp->readAll());
-  emit serialPortDataReceived(spData);
+  Trace::Span span("SerialPort::spDataReceived");
+  qsizetype received = 0;
+  while (spData.freeSpace() && sp->bytesAvailable()) { // read straight into the free space of our buffer, at most twice when the data wraps around
+    const RingBuffer::WritableSpan dst = spData.writableSpan();
+    const qint64 bytesRead = sp->read(reinterpret_cast<char*>(dst.data), dst.length);
+    if (bytesRead <= 0)
+      break;
+    spData.commit(bytesRead);
+    received += bytesRead;
+  }
+
+  span.setArg("bytes", received);
+  if (received)
+    emit serialPortDataReceived(spData.lastWritten(received));
 }
 
 void SerialPort::spError(const QSerialPort::SerialPortError& error) {
@@ -5,6 +5,8 @@
 #include <QSerialPort>
 #include <QSerialPortInfo>
 
+#include "RingBuffer.h"
+
 class SerialPort : public QObject {
   Q_OBJECT
 public:
@@ -14,15 +16,20 @@ public:
 public:
   bool openSerialPort(); // opens selected serial port and returns true or false if port can't be opened
   bool writeDataToSerialPort(const QByteArray& dataToWrite);
-  // Removes the desired number of bytes from the buffer and, if successful, returns the number of bytes removed.
+  // Removes the desired number of bytes from the buffer in O(1) and, if successful, returns the number of bytes left in the buffer.
   // If more data is requested to be deleted than is currently in the buffer, nothing is deleted and the current amount of data is returned.
-  ushort removeDataFromBufferStart(const ushort& howManyBytes);
+  qsizetype removeDataFromBufferStart(const qsizetype& howManyBytes);
+  RingBuffer::View bufferedData() const { return spData.view(); }                                  // all received data that wasn't removed yet, valid until the buffer is modified
+  quint64 bytesCopiedToBuffer() const { return spData.totalWritten(); }                            // each received byte is copied only once, from Qt's buffer into ours
   void clearDataBuffer();                                                                          // clears our internal data buffer
   bool clearSerialPortDataBuffer(const QSerialPort::Directions& dir = QSerialPort::AllDirections); // clears Qt's data buffer
   void closeSerialPort();
+  // Puts the data into the buffer as if it was received from the serial port, used to replay captured sessions.
+  // Returns how many bytes fit into the buffer, the rest must be fed again once some data was removed from it.
+  qsizetype feedData(const uchar* data, qsizetype len);
 
 signals:
-  void serialPortDataReceived(const QByteArray& dataBuff);
+  void serialPortDataReceived(const RingBuffer::View& newData); // only the bytes received since the last emission
   void serialPortError(const QSerialPort::SerialPortError& error);
 
 private slots:
@@ -33,7 +40,8 @@ private:
   QString spName; // name of the selected serial port
   QSerialPort* sp = nullptr;
   QSerialPortInfo spInfo;
-  QByteArray spData; // internal buffer for the received data
+  static constexpr qsizetype bufferCapacity = 128 * 1024; // the longest type 2 packet (64 KiB) always fits
+  RingBuffer spData{bufferCapacity};                      // internal buffer for the received data
 };
 
 #endif // SERIALPORT_H
@@ -0,0 +1,213 @@
+#include "SerialWorker.h"
+
+#include "Trace.h"
+
+SerialWorker::SerialWorker(SpscQueue<DecodedFrame>& frameQueue, PipelineMetrics& metrics, QObject* parent) : QObject{parent}, frameQueue(frameQueue), metrics(metrics) {
+  retryTimer = new QTimer(this);
+  retryTimer->setInterval(10);
+  connect(retryTimer, &QTimer::timeout, this, &SerialWorker::flushPendingFrames);
+
+  replayTimer = new QTimer(this);
+  replayTimer->setSingleShot(true);
+  connect(replayTimer, &QTimer::timeout, this, &SerialWorker::replayChunks);
+
+  connect(&frameDecoder, &FrameDecoder::battInfoFrameReceived, this, &SerialWorker::onBattInfoFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::chartFrameReceived, this, &SerialWorker::onChartFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::chartDisplayFrameReceived, this, &SerialWorker::onChartDisplayFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::checksumFailed, this, [this]() { this->metrics.add(PipelineMetrics::Counter::ChecksumFailures); });
+  connect(&frameDecoder, &FrameDecoder::resynchronised, this, [this](qsizetype droppedBytes) {
+    this->metrics.add(PipelineMetrics::Counter::Resyncs);
+    this->metrics.add(PipelineMetrics::Counter::DroppedBytes, droppedBytes);
+  });
+}
+
+SerialWorker::~SerialWorker() { closeSerialPort(); }
+
+void SerialWorker::openSerialPort(const QString& portName, const QString& captureFileName) {
+  closeSerialPort();
+
+  sp = new SerialPort(portName, this);
+  connect(sp, &SerialPort::serialPortDataReceived, this, &SerialWorker::onSerialPortDataReceived);
+  connect(sp, &SerialPort::serialPortError, this, &SerialWorker::onSerialPortError);
+
+  const bool success = sp->openSerialPort();
+  if (success) {
+    frameDecoder.reset();
+    sp->clearDataBuffer();
+    sp->clearSerialPortDataBuffer();
+    if (!captureFileName.isEmpty() && !captureWriter.open(captureFileName))
+      emit captureError(captureWriter.errorString()); // connection is still usable without recording
+  } else {
+    delete sp;
+    sp = nullptr;
+  }
+  emit serialPortOpened(success);
+}
+
+void SerialWorker::closeSerialPort() {
+  cancelFirmwareUpdate();
+  replayTimer->stop();
+  replayChunkPending = false;
+  captureReader.close();
+  captureWriter.close();
+  if (sp == nullptr)
+    return;
+
+  sp->closeSerialPort();
+  delete sp;
+  sp = nullptr;
+  frameDecoder.reset();
+}
+
+void SerialWorker::replayCapture(const QString& fileName, bool realTime) {
+  closeSerialPort();
+
+  if (!captureReader.open(fileName)) {
+    emit replayStarted(false, captureReader.errorString());
+    return;
+  }
+
+  sp = new SerialPort(QString(), this); // never opened, replayed data is fed into its buffer
+  connect(sp, &SerialPort::serialPortDataReceived, this, &SerialWorker::onSerialPortDataReceived);
+  frameDecoder.reset();
+  replayRealTime = realTime;
+  replayClock.start();
+  emit replayStarted(true, QString());
+  replayTimer->start(0);
+}
+
+void SerialWorker::startFirmwareUpdate(const QString& imageFileName) {
+  if (sp == nullptr || captureReader.isOpen()) { // a replay has no tester to talk to
+    emit firmwareUpdateFinished(false, tr("The tester isn't connected."));
+    return;
+  }
+
+  if (firmwareUpdater == nullptr) {
+    firmwareUpdater = new FirmwareUpdater([this](const QByteArray& packet) { return sp != nullptr && sp->writeDataToSerialPort(packet); }, FirmwareUpdater::Config(), this);
+    connect(firmwareUpdater, &FirmwareUpdater::progressChanged, this, &SerialWorker::firmwareUpdateProgress);
+    connect(firmwareUpdater, &FirmwareUpdater::finished, this, &SerialWorker::firmwareUpdateFinished);
+    connect(&frameDecoder, &FrameDecoder::firmwareFrameReceived, firmwareUpdater, &FirmwareUpdater::handlePacket);
+  }
+  firmwareUpdater->start(imageFileName);
+}
+
+void SerialWorker::cancelFirmwareUpdate() {
+  if (firmwareUpdater != nullptr)
+    firmwareUpdater->cancel();
+}
+
+void SerialWorker::onSerialPortDataReceived(const RingBuffer::View& newData) {
+  chunkReceivedNs = PipelineMetrics::now();
+  metrics.add(PipelineMetrics::Counter::BytesReceived, newData.length());
+  if (captureWriter.isOpen() && !captureWriter.writeChunk(newData)) {
+    emit captureError(captureWriter.errorString());
+    captureWriter.close();
+  }
+  // decoder remembers how much of the buffered data it has already seen
+  sp->removeDataFromBufferStart(frameDecoder.decode(sp->bufferedData()));
+}
+
+void SerialWorker::onSerialPortError(const QSerialPort::SerialPortError& error) {
+  if (error == QSerialPort::NoError)
+    return;
+  emit serialPortError(error);
+}
+
+void SerialWorker::flushPendingFrames() {
+  qsizetype flushed = 0;
+  while (flushed < pendingFrames.size() && frameQueue.push(std::move(pendingFrames[flushed])))
+    flushed++;
+  pendingFrames.remove(0, flushed);
+  metrics.setQueueDepth(frameQueue.size() + pendingFrames.size());
+
+  if (pendingFrames.isEmpty())
+    retryTimer->stop();
+  if (flushed)
+    notifyConsumer();
+}
+
+void SerialWorker::replayChunks() {
+  qsizetype batch = 0;
+  while (replayChunkPending || captureReader.readChunk(replayChunk)) {
+    replayChunkPending = true;
+    if (replayRealTime) {
+      const qint64 delay = static_cast<qint64>(replayChunk.timestampNs / 1000000) - replayClock.elapsed();
+      if (delay > 0) {
+        replayTimer->start(delay);
+        return;
+      }
+    } else if (batch >= replayBatchSize) { // let the event loop handle other requests, e.g. to stop the replay
+      replayTimer->start(0);
+      return;
+    }
+
+    replayChunkPending = false;
+    if (!feedChunk(replayChunk))
+      break;
+    batch += replayChunk.length;
+  }
+  finishReplay();
+}
+
+bool SerialWorker::feedChunk(const CaptureReader::Chunk& chunk) {
+  qsizetype fed = 0;
+  while (fed < chunk.length) { // data is decoded and removed from the buffer before feedData() returns
+    const qsizetype written = sp->feedData(chunk.data + fed, chunk.length - fed);
+    if (!written)
+      return false; // decoder can't free any space, which can't happen with a buffer larger than the longest packet
+    fed += written;
+  }
+  return true;
+}
+
+void SerialWorker::finishReplay() {
+  closeSerialPort();
+  emit replayFinished();
+}
+
+void SerialWorker::onBattInfoFrameReceived(const RingBuffer::View& text) {
+  DecodedFrame frame;
+  frame.type = DecodedFrame::Type::BattInfo;
+  frame.text = text.toByteArray();
+  metrics.add(PipelineMetrics::Counter::BattInfoFrames);
+  queueFrame(std::move(frame));
+}
+
+void SerialWorker::onChartFrameReceived(const RingBuffer::View& samples) {
+  DecodedFrame frame;
+  frame.type = DecodedFrame::Type::Chart;
+  frame.samples.resize(samples.length() / 2);
+  for (qsizetype i = 0; i < frame.samples.size(); i++) // lower byte is transmitted first
+    frame.samples[i] = (samples[2 * i + 1] << 8) | samples[2 * i];
+  metrics.add(PipelineMetrics::Counter::ChartFrames);
+  queueFrame(std::move(frame));
+}
+
+void SerialWorker::onChartDisplayFrameReceived() {
+  DecodedFrame frame;
+  frame.type = DecodedFrame::Type::ChartDisplay;
+  metrics.add(PipelineMetrics::Counter::ChartDisplayFrames);
+  queueFrame(std::move(frame));
+}
+
+void SerialWorker::queueFrame(DecodedFrame&& frame) {
+  frame.receivedNs = chunkReceivedNs;
+  frame.traceId = Trace::flowStart("frame");
+  metrics.decodeLatency.record(PipelineMetrics::now() - chunkReceivedNs);
+
+  if (!pendingFrames.isEmpty() || !frameQueue.push(std::move(frame))) { // keep the order of frames if some of them are already waiting
+    if (pendingFrames.isEmpty()) // counted once until the held back frames are all queued
+      metrics.add(PipelineMetrics::Counter::QueueFull);
+    pendingFrames.append(std::move(frame));
+    retryTimer->start();
+    metrics.setQueueDepth(frameQueue.size() + pendingFrames.size());
+    return;
+  }
+  metrics.setQueueDepth(frameQueue.size());
+  notifyConsumer();
+}
+
+void SerialWorker::notifyConsumer() {
+  if (!notificationPending.exchange(true, std::memory_order_acq_rel)) // consumer will take all frames queued until it acknowledges them
+    emit framesAvailable();
+}
@@ -0,0 +1,87 @@
+#ifndef SERIALWORKER_H
+#define SERIALWORKER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <atomic>
+
+#include "CaptureFile.h"
+#include "DecodedFrame.h"
+#include "FirmwareUpdater.h"
+#include "FrameDecoder.h"
+#include "PipelineMetrics.h"
+#include "SerialPort.h"
+#include "SpscQueue.h"
+
+// Serial port reading and packet decoding, meant to live in its own thread so a busy UI never delays them.
+// Decoded packets are passed to the UI through a lock-free queue, framesAvailable() is emitted once for a whole batch of them.
+class SerialWorker : public QObject {
+  Q_OBJECT
+public:
+  SerialWorker(SpscQueue<DecodedFrame>& frameQueue, PipelineMetrics& metrics, QObject* parent = nullptr);
+  ~SerialWorker();
+
+public:
+  // Called by the consumer before it starts taking frames from the queue, so frames queued after that will be announced again.
+  void acknowledgeFrames() { notificationPending.store(false, std::memory_order_release); }
+
+public slots:
+  void openSerialPort(const QString& portName, const QString& captureFileName = QString()); // received data is recorded if capture file name is given
+  void closeSerialPort();                                                                    // also stops the replay
+  // Feeds a recorded session through the same decoding path as the data received from the serial port,
+  // with the original timing or as fast as possible.
+  void replayCapture(const QString& fileName, bool realTime);
+  // Sends the image to the bootloader of the connected tester, the result is always reported with firmwareUpdateFinished().
+  void startFirmwareUpdate(const QString& imageFileName);
+  void cancelFirmwareUpdate();
+
+signals:
+  void serialPortOpened(bool success);
+  void serialPortError(const QSerialPort::SerialPortError& error);
+  void framesAvailable();
+  void captureError(const QString& errorString);
+  void replayStarted(bool success, const QString& errorString);
+  void replayFinished();
+  void firmwareUpdateProgress(qint64 doneBytes, qint64 totalBytes);
+  void firmwareUpdateFinished(bool success, const QString& errorString); // empty error string when the update was cancelled
+
+private slots:
+  void onSerialPortDataReceived(const RingBuffer::View& newData);
+  void onSerialPortError(const QSerialPort::SerialPortError& error);
+  void flushPendingFrames();
+  void replayChunks();
+
+private:
+  void onBattInfoFrameReceived(const RingBuffer::View& text);
+  void onChartFrameReceived(const RingBuffer::View& samples);
+  void onChartDisplayFrameReceived();
+  void queueFrame(DecodedFrame&& frame);
+  void notifyConsumer();
+  bool feedChunk(const CaptureReader::Chunk& chunk);
+  void finishReplay();
+
+private:
+  SpscQueue<DecodedFrame>& frameQueue;
+  QVector<DecodedFrame> pendingFrames; // frames that didn't fit into the queue because the consumer is busy, no data is dropped
+  QTimer* retryTimer = nullptr;
+  std::atomic_bool notificationPending{false};
+  PipelineMetrics& metrics;
+  qint64 chunkReceivedNs = 0; // when the data being decoded was received
+
+  SerialPort* sp = nullptr;
+  FrameDecoder frameDecoder;
+  FirmwareUpdater* firmwareUpdater = nullptr; // created with the first update
+
+  CaptureWriter captureWriter;
+  CaptureReader captureReader;
+  CaptureReader::Chunk replayChunk;
+  bool replayChunkPending = false; // chunk was read, but its time hasn't come yet
+  bool replayRealTime = false;
+  QElapsedTimer replayClock;
+  QTimer* replayTimer = nullptr;
+  static constexpr qsizetype replayBatchSize = 1024 * 1024; // when replaying as fast as possible, return to the event loop after that many bytes
+};
+
+#endif // SERIALWORKER_H
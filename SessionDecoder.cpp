@@ -0,0 +1,46 @@
+#include "SessionDecoder.h"
+
+SessionDecoder::SessionDecoder(QObject* parent) : QObject{parent} {
+  connect(&frameDecoder, &FrameDecoder::battInfoFrameReceived, this, &SessionDecoder::onBattInfoFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::chartFrameReceived, this, &SessionDecoder::onChartFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::chartDisplayFrameReceived, this, &SessionDecoder::onChartDisplayFrameReceived);
+  connect(&frameDecoder, &FrameDecoder::checksumFailed, this, [this]() { checksumErrors++; });
+  connect(&frameDecoder, &FrameDecoder::resynchronised, this, [this](qsizetype droppedBytes) { dropped += droppedBytes; });
+}
+
+void SessionDecoder::feed(const uchar* data, qsizetype len) {
+  while (len > 0) {
+    const qsizetype written = buffer.write(data, len);
+    buffer.consume(frameDecoder.decode(buffer.view()));
+    if (!written && buffer.freeSpace() == 0)
+      break; // decoder can't free any space, which can't happen with a buffer larger than the longest packet
+    data += written;
+    len -= written;
+  }
+}
+
+void SessionDecoder::reset() {
+  buffer.clear();
+  frameDecoder.reset();
+  receivedWaveform.clear();
+  checksumErrors = dropped = 0;
+}
+
+void SessionDecoder::onBattInfoFrameReceived(const RingBuffer::View& text) {
+  if (BattInfo::parse(text, battInfo))
+    emit battInfoDecoded(battInfo);
+}
+
+void SessionDecoder::onChartFrameReceived(const RingBuffer::View& samples) {
+  chartSamples.resize(samples.length() / 2);
+  for (qsizetype i = 0; i < chartSamples.size(); i++) // lower byte is transmitted first
+    chartSamples[i] = (samples[2 * i + 1] << 8) | samples[2 * i];
+  receivedWaveform.append(chartSamples); // packets of the same type are continuation of the current chart
+}
+
+void SessionDecoder::onChartDisplayFrameReceived() {
+  if (receivedWaveform.isEmpty())
+    return; // nothing to display
+  emit waveformDecoded(receivedWaveform);
+  receivedWaveform.clear();
+}
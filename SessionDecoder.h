@@ -0,0 +1,45 @@
+#ifndef SESSIONDECODER_H
+#define SESSIONDECODER_H
+
+#include <QObject>
+
+#include "BattInfo.h"
+#include "FrameDecoder.h"
+#include "RingBuffer.h"
+#include "Waveform.h"
+
+// Decodes a stream of data received from the tester into complete test results, without any serial port or UI.
+// Chart packets are collected until the tester asks to display the chart, exactly as the application does it.
+class SessionDecoder : public QObject {
+  Q_OBJECT
+public:
+  explicit SessionDecoder(QObject* parent = nullptr);
+
+public:
+  void feed(const uchar* data, qsizetype len); // decodes everything that can be decoded, results are emitted before it returns
+  void reset();
+
+  quint64 checksumFailures() const { return checksumErrors; }
+  quint64 droppedBytes() const { return dropped; }
+
+signals:
+  void battInfoDecoded(const BattInfo& info);
+  void waveformDecoded(const Waveform& waveform); // valid only during the emission
+
+private:
+  void onBattInfoFrameReceived(const RingBuffer::View& text);
+  void onChartFrameReceived(const RingBuffer::View& samples);
+  void onChartDisplayFrameReceived();
+
+private:
+  static constexpr qsizetype bufferCapacity = 128 * 1024; // the longest type 2 packet (64 KiB) always fits
+  RingBuffer buffer{bufferCapacity};
+  FrameDecoder frameDecoder;
+  Waveform receivedWaveform;
+  QVector<ushort> chartSamples; // reused for every chart packet
+  BattInfo battInfo;            // reused for every type 1 packet, so its strings don't allocate while nobody keeps a copy
+  quint64 checksumErrors = 0;
+  quint64 dropped = 0;
+};
+
+#endif // SESSIONDECODER_H
@@ -0,0 +1,54 @@
+#include "SessionManager.h"
+
+SessionManager::SessionManager(QObject* parent) : QObject{parent} {}
+
+SessionManager::~SessionManager() {
+  clear(); // workers are deleted in their threads, so the threads must still be running
+  for (QThread* thread : std::as_const(workerThreads)) {
+    thread->quit();
+    thread->wait();
+    delete thread;
+  }
+}
+
+DeviceSession* SessionManager::addSession(const QString& name) {
+  DeviceSession* session = new DeviceSession(name, nextThread(), this);
+  deviceSessions.append(session);
+  emit sessionAdded(session);
+  return session;
+}
+
+void SessionManager::closeAll() {
+  for (DeviceSession* session : std::as_const(deviceSessions))
+    session->close();
+}
+
+void SessionManager::clear() {
+  if (deviceSessions.isEmpty())
+    return;
+
+  emit aboutToClear();
+  qDeleteAll(deviceSessions); // each one waits until its worker has closed the port
+  deviceSessions.clear();
+  nextThreadIndex = 0;
+}
+
+bool SessionManager::isAnyActive() const {
+  for (const DeviceSession* session : deviceSessions)
+    if (session->isActive())
+      return true;
+  return false;
+}
+
+QThread* SessionManager::nextThread() {
+  if (workerThreads.size() < qMax(QThread::idealThreadCount(), 1) && nextThreadIndex == workerThreads.size()) {
+    QThread* thread = new QThread;
+    thread->setObjectName(QString("SerialWorker %1").arg(workerThreads.size()));
+    thread->start(QThread::TimeCriticalPriority);
+    workerThreads.append(thread);
+  }
+
+  QThread* thread = workerThreads[nextThreadIndex];
+  nextThreadIndex = (nextThreadIndex + 1) % qMax(QThread::idealThreadCount(), 1);
+  return thread;
+}
@@ -0,0 +1,38 @@
+#ifndef SESSIONMANAGER_H
+#define SESSIONMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QVector>
+
+#include "DeviceSession.h"
+
+// Testers connected at the same time. Workers of all sessions share a pool of threads, at most one for each core,
+// sessions are spread over them, so the reading and decoding of one port never waits for another one on a different thread.
+class SessionManager : public QObject {
+  Q_OBJECT
+public:
+  explicit SessionManager(QObject* parent = nullptr);
+  ~SessionManager();
+
+public:
+  DeviceSession* addSession(const QString& name);
+  void closeAll();
+  void clear(); // closes and removes all sessions
+  const QVector<DeviceSession*>& sessions() const { return deviceSessions; }
+  bool isAnyActive() const;
+
+signals:
+  void sessionAdded(DeviceSession* session);
+  void aboutToClear(); // sessions are still valid during the emission
+
+private:
+  QThread* nextThread();
+
+private:
+  QVector<QThread*> workerThreads;
+  qsizetype nextThreadIndex = 0;
+  QVector<DeviceSession*> deviceSessions;
+};
+
+#endif // SESSIONMANAGER_H
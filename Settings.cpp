@@ -0,0 +1,78 @@
+#include "Settings.h"
+
+#include <QSettings>
+
+#include "SettingsNames.h"
+
+Settings::Settings(const QString& fileName, QObject* parent) : QObject{parent}, settingsFileName(fileName) {
+  saveTimer.setSingleShot(true);
+  saveTimer.setInterval(saveDelay);
+  connect(&saveTimer, &QTimer::timeout, this, &Settings::sync);
+  load();
+}
+
+Settings::~Settings() { sync(); }
+
+Settings& Settings::instance() {
+  static Settings settings(sSettingsFileName);
+  return settings;
+}
+
+void Settings::setConnection(const Connection& connection) {
+  if (connection == conn)
+    return;
+
+  conn = connection;
+  empty = false;
+  saveTimer.start();
+  emit connectionChanged(conn);
+}
+
+void Settings::setDisplay(const Display& display) {
+  if (display == disp)
+    return;
+
+  disp = display;
+  empty = false;
+  saveTimer.start();
+  emit displayChanged(disp);
+}
+
+bool Settings::sync() {
+  if (!saveTimer.isActive())
+    return true; // nothing changed since the last write
+  saveTimer.stop();
+
+  QSettings settings(settingsFileName, QSettings::IniFormat);
+  settings.beginGroup(sGroup);
+  settings.setValue(sPort, conn.portName);
+  settings.setValue(sPortDesc, conn.portDescription);
+  settings.setValue(sAutoConnect, conn.autoConnect);
+  settings.setValue(sRecordCapture, conn.recordCapture);
+  settings.setValue(sAdditionalPorts, conn.additionalPorts);
+  settings.setValue(sFirmwareUpdate, conn.firmwareUpdate);
+  settings.endGroup();
+  settings.beginGroup(sDisplayGroup);
+  settings.setValue(sLiveWaveform, disp.liveWaveform);
+  settings.endGroup();
+  settings.sync();
+  return settings.status() == QSettings::NoError;
+}
+
+void Settings::load() {
+  QSettings settings(settingsFileName, QSettings::IniFormat);
+  empty = settings.allKeys().isEmpty();
+
+  settings.beginGroup(sGroup);
+  conn.portName = settings.value(sPort, QString()).toString();
+  conn.portDescription = settings.value(sPortDesc, QString()).toString();
+  conn.autoConnect = settings.value(sAutoConnect, bool()).toBool();
+  conn.recordCapture = settings.value(sRecordCapture, bool()).toBool();
+  conn.additionalPorts = settings.value(sAdditionalPorts, QStringList()).toStringList();
+  conn.firmwareUpdate = settings.value(sFirmwareUpdate, bool()).toBool();
+  settings.endGroup();
+
+  settings.beginGroup(sDisplayGroup);
+  disp.liveWaveform = settings.value(sLiveWaveform, Display().liveWaveform).toBool();
+  settings.endGroup();
+}
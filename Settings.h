@@ -0,0 +1,65 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+// Application settings, read from the settings file once at startup and kept in memory, so reading them never touches the disk.
+// Changes are written back shortly after they are made (all changes made in the meantime with a single write),
+// QSettings replaces the file atomically, so it's never left half-written. Interested objects are notified about the changes.
+class Settings : public QObject {
+  Q_OBJECT
+public:
+  struct Connection {
+    QString portName;
+    QString portDescription;
+    bool autoConnect = false;
+    bool recordCapture = false;  // received data is recorded to a capture file
+    QStringList additionalPorts; // other testers connected at the same time
+    bool firmwareUpdate = false; // Device->Firmware update is offered, it speaks only the protocol of the tester emulator
+
+    QStringList allPorts() const { return QStringList{portName} + additionalPorts; }
+    bool operator==(const Connection& other) const {
+      return portName == other.portName && portDescription == other.portDescription && autoConnect == other.autoConnect && recordCapture == other.recordCapture &&
+             additionalPorts == other.additionalPorts && firmwareUpdate == other.firmwareUpdate;
+    }
+    bool operator!=(const Connection& other) const { return !(*this == other); }
+  };
+
+  struct Display {
+    bool liveWaveform = true; // chart is drawn while its packets are received, not only when the tester asks to display it
+
+    bool operator==(const Display& other) const { return liveWaveform == other.liveWaveform; }
+    bool operator!=(const Display& other) const { return !(*this == other); }
+  };
+
+public:
+  static Settings& instance(); // created on the first use, must be used only from the GUI thread
+
+  bool isEmpty() const { return empty; } // settings file didn't exist or had no settings when it was read
+  const Connection& connection() const { return conn; }
+  void setConnection(const Connection& connection);
+  const Display& display() const { return disp; }
+  void setDisplay(const Display& display);
+  bool sync(); // writes pending changes right away, returns false if the file couldn't be written
+
+signals:
+  void connectionChanged(const Settings::Connection& connection);
+  void displayChanged(const Settings::Display& display);
+
+private:
+  explicit Settings(const QString& fileName, QObject* parent = nullptr);
+  ~Settings();
+  void load();
+
+private:
+  static constexpr int saveDelay = 500; // ms
+  QString settingsFileName;
+  QTimer saveTimer;
+  bool empty = true;
+  Connection conn;
+  Display disp;
+};
+
+#endif // SETTINGS_H
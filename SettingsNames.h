@@ -7,5 +7,11 @@
 #define sPort "comPortName"
 #define sPortDesc "comPortDescription"
 #define sAutoConnect "autoConnect"
+#define sRecordCapture "recordCapture"
+#define sAdditionalPorts "additionalComPortNames"
+#define sFirmwareUpdate "emulatorFirmwareUpdate"
+
+#define sDisplayGroup "Display"
+#define sLiveWaveform "liveWaveform"
 
 #endif // SETTINGSNAMES_H
@@ -0,0 +1,57 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// Lock-free single-producer/single-consumer queue with a fixed capacity. push() may be called only from one thread and pop() only from one
+// (possibly other) thread. Elements are moved in and out of preallocated slots, so the queue itself doesn't allocate after construction.
+template <typename T>
+class SpscQueue {
+public:
+  explicit SpscQueue(qsizetype minCapacity) {
+    qsizetype cap = 1;
+    while (cap < minCapacity)
+      cap <<= 1;
+    elements = std::make_unique<T[]>(cap); // plain array, QVector would check for detaching on every access from both threads
+    mask = cap - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // producer side, returns false if the queue is full and the value wasn't moved
+  bool push(T&& value) {
+    const quint64 t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == static_cast<quint64>(mask + 1))
+      return false;
+    elements[t & mask] = std::move(value);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side, returns false if the queue is empty
+  bool pop(T& value) {
+    const quint64 h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+      return false;
+    value = std::move(elements[h & mask]);
+    elements[h & mask] = T(); // release resources held by the element right away
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // number of queued elements, exact only when called from the producer or the consumer thread while the other one is idle
+  qsizetype size() const { return static_cast<qsizetype>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire)); }
+  qsizetype capacity() const { return mask + 1; }
+
+private:
+  std::unique_ptr<T[]> elements;
+  qsizetype mask = 0;
+  alignas(64) std::atomic<quint64> head{0}; // written only by the consumer
+  alignas(64) std::atomic<quint64> tail{0}; // written only by the producer
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,182 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace Trace {
+namespace {
+struct Event {
+  const char* name = nullptr;
+  const char* argName = nullptr;
+  qint64 argValue = 0;
+  qint64 startNs = 0;
+  qint64 durationNs = 0;
+  quint32 flowId = 0;
+  char phase = 'X'; // complete event, or 's' and 'f' for the start and end of a flow
+};
+
+// Written only by its thread, read only by writeJson(). Buffers are kept after their threads finish, so their events can still be written.
+struct ThreadBuffer {
+  static constexpr quint64 capacity = 1 << 16; // 3 MiB per thread
+
+  std::unique_ptr<Event[]> events{new Event[capacity]};
+  std::atomic<quint64> written{0};
+  quint64 firstTraced = 0; // value of written when tracing was started, guarded by the registry mutex
+  int tid = 0;
+  QByteArray threadName;
+};
+
+struct Registry {
+  QMutex mutex; // taken once per thread, when it records its first event, and when tracing is started or written
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  qint64 startNs = 0;
+};
+
+Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+std::atomic<quint32> lastFlowId{0};
+thread_local ThreadBuffer* currentBuffer = nullptr;
+
+ThreadBuffer* threadBuffer() {
+  if (currentBuffer)
+    return currentBuffer;
+
+  Registry& r = registry();
+  const QMutexLocker locker(&r.mutex);
+  r.buffers.push_back(std::make_unique<ThreadBuffer>());
+  currentBuffer = r.buffers.back().get();
+  currentBuffer->tid = static_cast<int>(r.buffers.size());
+  const QThread* thread = QThread::currentThread();
+  if (!thread->objectName().isEmpty())
+    currentBuffer->threadName = thread->objectName().toUtf8();
+  else if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+    currentBuffer->threadName = "main";
+  else
+    currentBuffer->threadName = "thread " + QByteArray::number(currentBuffer->tid);
+  return currentBuffer;
+}
+
+void record(const Event& event) {
+  ThreadBuffer* buffer = threadBuffer();
+  const quint64 pos = buffer->written.load(std::memory_order_relaxed);
+  buffer->events[pos & (ThreadBuffer::capacity - 1)] = event;
+  buffer->written.store(pos + 1, std::memory_order_release);
+}
+
+void appendEscaped(QByteArray& json, const QByteArray& text) {
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      json += '\\';
+    if (static_cast<uchar>(c) >= 0x20)
+      json += c;
+  }
+}
+
+void appendEvent(QByteArray& json, const Event& event, int tid, qint64 startNs) {
+  json += "{\"name\":\"";
+  appendEscaped(json, event.name);
+  json += "\",\"cat\":\"kbtinfo\",\"ph\":\"";
+  json += event.phase;
+  json += "\",\"pid\":1,\"tid\":" + QByteArray::number(tid) + ",\"ts\":" + QByteArray::number((event.startNs - startNs) / 1000.0, 'f', 3);
+  if (event.phase == 'X')
+    json += ",\"dur\":" + QByteArray::number(event.durationNs / 1000.0, 'f', 3);
+  else
+    json += ",\"id\":" + QByteArray::number(event.flowId) + (event.phase == 'f' ? ",\"bp\":\"e\"" : "");
+  if (event.argName) {
+    json += ",\"args\":{\"";
+    appendEscaped(json, event.argName);
+    json += "\":" + QByteArray::number(event.argValue) + '}';
+  }
+  json += "},\n";
+}
+} // namespace
+
+qint64 now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+void start() {
+  Registry& r = registry();
+  const QMutexLocker locker(&r.mutex);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : r.buffers)
+    buffer->firstTraced = buffer->written.load(std::memory_order_acquire);
+  r.startNs = now();
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() { enabled.store(false, std::memory_order_relaxed); }
+
+bool writeJson(QIODevice& device) {
+  static constexpr qsizetype chunkSize = 64 * 1024;
+  Registry& r = registry();
+  const QMutexLocker locker(&r.mutex);
+
+  QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  json.reserve(chunkSize + 1024);
+  for (const std::unique_ptr<ThreadBuffer>& buffer : r.buffers) {
+    json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->tid) + ",\"args\":{\"name\":\"";
+    appendEscaped(json, buffer->threadName);
+    json += "\"}},\n";
+
+    const quint64 last = buffer->written.load(std::memory_order_acquire);
+    const quint64 first = qMax(buffer->firstTraced, last > ThreadBuffer::capacity ? last - ThreadBuffer::capacity : 0);
+    for (quint64 i = first; i < last; i++) {
+      const Event& event = buffer->events[i & (ThreadBuffer::capacity - 1)];
+      if (event.startNs < r.startNs)
+        continue; // recorded by a span that started before tracing
+      appendEvent(json, event, buffer->tid, r.startNs);
+      if (json.size() >= chunkSize) {
+        if (device.write(json) != json.size())
+          return false;
+        json.clear();
+      }
+    }
+  }
+  // every event is followed by a comma, so the list ends with one more metadata event to stay valid JSON
+  json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"";
+  appendEscaped(json, QCoreApplication::applicationName().toUtf8());
+  json += "\"}}\n]}\n";
+  return device.write(json) == json.size();
+}
+
+quint32 flowStart(const char* name) {
+  if (!isEnabled())
+    return 0;
+  Event event;
+  event.name = name;
+  event.startNs = now();
+  event.flowId = lastFlowId.fetch_add(1, std::memory_order_relaxed) + 1;
+  event.phase = 's';
+  record(event);
+  return event.flowId;
+}
+
+void flowEnd(const char* name, quint32 id) {
+  if (!id || !isEnabled())
+    return;
+  Event event;
+  event.name = name;
+  event.startNs = now();
+  event.flowId = id;
+  event.phase = 'f';
+  record(event);
+}
+
+void Span::finish() {
+  if (!isEnabled()) // stopped in the meantime, the buffers may be being written
+    return;
+  Event event;
+  event.name = spanName;
+  event.argName = argName;
+  event.argValue = argValue;
+  event.startNs = startNs;
+  event.durationNs = now() - startNs;
+  record(event);
+}
+} // namespace Trace
@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QIODevice>
+
+#include <atomic>
+
+// Optional tracing of the way of a frame from the serial port to the screen, written in the Chrome trace event format (chrome://tracing,
+// ui.perfetto.dev). Every thread records into its own ring buffer without locks. When tracing is disabled, a span costs a single relaxed load.
+namespace Trace {
+inline std::atomic_bool enabled{false};
+
+inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+qint64 now(); // monotonic time in ns
+
+void start(); // events recorded before aren't written
+void stop();
+// Writes the events recorded since start(), the oldest ones are lost when a thread recorded more than fits into its buffer.
+// Call it after stop(), so the buffers aren't written at the same time.
+bool writeJson(QIODevice& device);
+
+// Flow arrows link the places where a frame was handled in different threads. flowStart() returns 0 when tracing is disabled,
+// and flowEnd() ignores it, so the id can be passed along with the frame unconditionally.
+quint32 flowStart(const char* name);
+void flowEnd(const char* name, quint32 id);
+
+// Measures the time until the end of the scope. Names must be string literals, only the pointers are stored.
+class Span {
+public:
+  explicit Span(const char* name) : spanName(isEnabled() ? name : nullptr) {
+    if (spanName)
+      startNs = now();
+  }
+  ~Span() {
+    if (spanName)
+      finish();
+  }
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+  void setArg(const char* name, qint64 value) { // shown in the details of the span
+    argName = name;
+    argValue = value;
+  }
+
+private:
+  void finish();
+
+private:
+  const char* spanName;
+  const char* argName = nullptr;
+  qint64 argValue = 0;
+  qint64 startNs = 0;
+};
+} // namespace Trace
+
+#endif // TRACE_H
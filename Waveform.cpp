@@ -0,0 +1,20 @@
+#include "Waveform.h"
+
+#include <algorithm>
+
+void Waveform::append(const ushort* samples, qsizetype count) {
+  const qsizetype oldSize = sampleData.size();
+  sampleData.resize(oldSize + count);
+  std::copy(samples, samples + count, sampleData.begin() + oldSize);
+
+  for (qsizetype i = 0; i < count; i++) {
+    minRaw = qMin(minRaw, samples[i]);
+    maxRaw = qMax(maxRaw, samples[i]);
+  }
+}
+
+void Waveform::clear() {
+  sampleData.clear();
+  minRaw = std::numeric_limits<ushort>::max();
+  maxRaw = 0;
+}
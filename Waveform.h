@@ -0,0 +1,54 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <QVector>
+
+#include <limits>
+
+// Sampling of the waveform. Time is derived from the integer sample index, so it doesn't accumulate any rounding errors.
+struct Timebase {
+  quint32 sampleIntervalUs = 12500; // the tester sends a sample every 12.5 ms
+
+  double timeAt(qsizetype index) const { return static_cast<double>(index) * sampleIntervalUs / 1e6; } // in seconds
+};
+
+// Voltage waveform stored as the raw 16-bit samples sent by the tester, in the order they were received.
+// This is the only copy of the data, chart, export and analysis read from it.
+class Waveform {
+public:
+  static constexpr double unitsPerVolt = 10.0; // samples are sent in 0.1 V units
+
+public:
+  Waveform() = default;
+  explicit Waveform(const Timebase& timebase) : tb(timebase) {}
+
+  void append(const ushort* samples, qsizetype count);
+  void append(const QVector<ushort>& samples) { append(samples.constData(), samples.size()); }
+  void reserve(qsizetype count) { sampleData.reserve(count); }
+  void clear(); // keeps the allocated memory
+
+  qsizetype size() const { return sampleData.size(); }
+  bool isEmpty() const { return sampleData.isEmpty(); }
+  const ushort* constData() const { return sampleData.constData(); }
+  const QVector<ushort>& samples() const { return sampleData; }
+  const Timebase& timebase() const { return tb; }
+
+  ushort sample(qsizetype index) const { return sampleData[index]; }
+  double voltageAt(qsizetype index) const { return sampleData[index] / unitsPerVolt; }
+  double timeAt(qsizetype index) const { return tb.timeAt(index); }
+  double duration() const { return isEmpty() ? 0.0 : tb.timeAt(size() - 1); }
+
+  // extremes are tracked while samples are appended, valid only for a non-empty waveform
+  ushort minSample() const { return minRaw; }
+  ushort maxSample() const { return maxRaw; }
+  double minVoltage() const { return minRaw / unitsPerVolt; }
+  double maxVoltage() const { return maxRaw / unitsPerVolt; }
+
+private:
+  QVector<ushort> sampleData;
+  Timebase tb;
+  ushort minRaw = std::numeric_limits<ushort>::max();
+  ushort maxRaw = 0;
+};
+
+#endif // WAVEFORM_H
@@ -0,0 +1,136 @@
+#include "WaveformAnalysis.h"
+
+#include <cmath>
+
+#include "Trace.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVEFORMANALYSIS_SSE2
+#endif
+
+namespace WaveformAnalysis {
+namespace {
+// Both kernels start at index 1, the first sample has no difference, but it's still checked for the minimum and the threshold.
+SampleStats scanTail(const ushort* samples, qsizetype from, qsizetype count, ushort threshold, SampleStats stats) {
+  for (qsizetype i = from; i < count; i++) {
+    if (samples[i] < stats.minSample) {
+      stats.minSample = samples[i];
+      stats.minIndex = i;
+    }
+    stats.belowThreshold += samples[i] < threshold;
+    const qint64 d = static_cast<short>(samples[i] - samples[i - 1]);
+    stats.squaredDifferences += static_cast<quint64>(d * d);
+  }
+  return stats;
+}
+
+SampleStats firstSample(const ushort* samples, ushort threshold) {
+  SampleStats stats;
+  stats.minSample = samples[0];
+  stats.belowThreshold = samples[0] < threshold;
+  return stats;
+}
+} // namespace
+
+SampleStats scanScalar(const ushort* samples, qsizetype count, ushort threshold) {
+  if (count <= 0)
+    return SampleStats();
+  return scanTail(samples, 1, count, threshold, firstSample(samples, threshold));
+}
+
+#if defined(WAVEFORMANALYSIS_SSE2)
+// Eight samples at a time. SSE2 compares only signed 16-bit values, so the samples are flipped by 0x8000 first, which keeps their order.
+// Lane minimums remember the first step where they were reached, steps are counted in 16 bits, so long waveforms are split into parts.
+SampleStats scanSimd(const ushort* samples, qsizetype count, ushort threshold) {
+  if (count <= 0)
+    return SampleStats();
+
+  constexpr qsizetype maxSteps = 0xFFFF;
+  SampleStats stats = firstSample(samples, threshold);
+  const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000)), minusOne = _mm_set1_epi16(-1);
+  const __m128i limit = _mm_xor_si128(_mm_set1_epi16(static_cast<short>(threshold)), flip);
+  __m128i below = _mm_setzero_si128(), squares = _mm_setzero_si128();
+
+  qsizetype i = 1;
+  while (count - i >= 8) {
+    const qsizetype steps = qMin((count - i) / 8, maxSteps);
+    const qsizetype partStart = i;
+    __m128i lowest = _mm_set1_epi16(0x7FFF), lowestStep = _mm_setzero_si128(), step = _mm_setzero_si128();
+    for (qsizetype s = 0; s < steps; s++, i += 8) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+      const __m128i flipped = _mm_xor_si128(v, flip);
+
+      const __m128i lower = _mm_cmplt_epi16(flipped, lowest); // strict, so the first occurrence is kept
+      lowest = _mm_min_epi16(lowest, flipped);
+      lowestStep = _mm_or_si128(_mm_and_si128(lower, step), _mm_andnot_si128(lower, lowestStep));
+      step = _mm_sub_epi16(step, minusOne);
+
+      below = _mm_add_epi32(below, _mm_madd_epi16(_mm_cmplt_epi16(flipped, limit), minusOne)); // -1 for every sample below, times -1
+
+      const __m128i d = _mm_sub_epi16(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i - 1)));
+      const __m128i sq = _mm_madd_epi16(d, d); // up to 2^31 for each pair, fits only in unsigned 32 bits
+      squares = _mm_add_epi64(squares, _mm_add_epi64(_mm_unpacklo_epi32(sq, _mm_setzero_si128()), _mm_unpackhi_epi32(sq, _mm_setzero_si128())));
+    }
+
+    alignas(16) ushort laneMin[8], laneStep[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(laneMin), _mm_xor_si128(lowest, flip));
+    _mm_store_si128(reinterpret_cast<__m128i*>(laneStep), lowestStep);
+    for (int lane = 0; lane < 8; lane++) {
+      const qsizetype index = partStart + qsizetype(laneStep[lane]) * 8 + lane;
+      if (laneMin[lane] < stats.minSample || (laneMin[lane] == stats.minSample && index < stats.minIndex)) {
+        stats.minSample = laneMin[lane];
+        stats.minIndex = index;
+      }
+    }
+  }
+
+  alignas(16) qint32 belowLanes[4];
+  alignas(16) quint64 squareLanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(belowLanes), below);
+  _mm_store_si128(reinterpret_cast<__m128i*>(squareLanes), squares);
+  stats.belowThreshold += qsizetype(belowLanes[0]) + belowLanes[1] + belowLanes[2] + belowLanes[3];
+  stats.squaredDifferences = squareLanes[0] + squareLanes[1];
+  return scanTail(samples, i, count, threshold, stats);
+}
+
+bool simdSupported() { return true; } // SSE2 is a part of every x86-64 CPU
+#else
+SampleStats scanSimd(const ushort* samples, qsizetype count, ushort threshold) { return scanScalar(samples, count, threshold); }
+
+bool simdSupported() { return false; }
+#endif
+
+WaveformMetrics analyze(const Waveform& waveform, const Parameters& parameters) {
+  const Trace::Span span("WaveformAnalysis::analyze");
+  WaveformMetrics res;
+  const qsizetype count = waveform.size();
+  if (count < 2)
+    return res;
+
+  const ushort threshold = static_cast<ushort>(qBound(0.0, std::ceil(parameters.thresholdVoltage * Waveform::unitsPerVolt), 65535.0));
+  const ushort* samples = waveform.constData();
+#if defined(WAVEFORMANALYSIS_SSE2)
+  const SampleStats stats = scanSimd(samples, count, threshold);
+#else
+  const SampleStats stats = scanScalar(samples, count, threshold);
+#endif
+
+  const double interval = waveform.timebase().sampleIntervalUs / 1e6;
+  const qsizetype settleSamples = qBound(qsizetype(1), qsizetype(parameters.settleDuration / interval), count);
+  quint64 settleSum = 0;
+  for (qsizetype i = count - settleSamples; i < count; i++)
+    settleSum += samples[i];
+
+  res.valid = true;
+  res.minVoltage = stats.minSample / Waveform::unitsPerVolt;
+  res.dipTime = waveform.timeAt(stats.minIndex);
+  res.timeUnderThreshold = stats.belowThreshold * interval;
+  res.rippleRms = std::sqrt(static_cast<double>(stats.squaredDifferences) / (count - 1)) / Waveform::unitsPerVolt;
+  res.settleVoltage = static_cast<double>(settleSum) / settleSamples / Waveform::unitsPerVolt;
+  const double settleTime = waveform.timeAt(count - settleSamples);
+  if (settleTime > res.dipTime)
+    res.recoverySlope = (res.settleVoltage - res.minVoltage) / (settleTime - res.dipTime);
+  return res;
+}
+} // namespace WaveformAnalysis
@@ -0,0 +1,38 @@
+#ifndef WAVEFORMANALYSIS_H
+#define WAVEFORMANALYSIS_H
+
+#include "Waveform.h"
+
+// Parameters of a cranking test, computed from the raw samples in a single pass.
+struct WaveformMetrics {
+  bool valid = false;              // false for a waveform too short to analyse
+  double minVoltage = 0.0;         // lowest voltage while the starter was cranking
+  double dipTime = 0.0;            // when the lowest voltage was reached, s since the start
+  double recoverySlope = 0.0;      // average rise from the dip to the settled voltage, V/s
+  double timeUnderThreshold = 0.0; // total time below the threshold voltage, s
+  double rippleRms = 0.0;          // RMS of the sample-to-sample changes, V
+  double settleVoltage = 0.0;      // mean voltage at the end of the test
+};
+
+namespace WaveformAnalysis {
+struct Parameters {
+  double thresholdVoltage = 9.6; // lowest voltage a healthy 12 V battery should keep while cranking
+  double settleDuration = 0.5;   // end of the test used for the settled voltage, s
+};
+
+// Results of the pass over the samples, the vector kernel gives exactly the same ones as the scalar loop.
+struct SampleStats {
+  ushort minSample = 0;
+  qsizetype minIndex = 0;         // first sample with the lowest value
+  qsizetype belowThreshold = 0;   // samples lower than the threshold
+  quint64 squaredDifferences = 0; // sum of squared differences of neighbouring samples, as 16-bit signed values
+};
+
+SampleStats scanScalar(const ushort* samples, qsizetype count, ushort threshold);
+SampleStats scanSimd(const ushort* samples, qsizetype count, ushort threshold); // requires simdSupported()
+bool simdSupported();
+
+WaveformMetrics analyze(const Waveform& waveform, const Parameters& parameters = Parameters()); // uses the fastest kernel
+} // namespace WaveformAnalysis
+
+#endif // WAVEFORMANALYSIS_H
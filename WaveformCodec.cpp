@@ -0,0 +1,154 @@
+#include "WaveformCodec.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVEFORMCODEC_SSE2
+#endif
+
+namespace WaveformCodec {
+namespace {
+inline ushort zigzag(ushort delta) { return static_cast<ushort>((delta << 1) ^ (static_cast<short>(delta) >> 15)); }
+inline ushort unzigzag(ushort value) { return static_cast<ushort>((value >> 1) ^ (0u - (value & 1))); }
+inline ushort wordAt(const uchar* block, qsizetype row, qsizetype lane) { return block[1 + row * 16 + lane * 2] | (block[2 + row * 16 + lane * 2] << 8); }
+
+// Checks the bit width of the block, returns its size or -1.
+inline qsizetype blockLength(const uchar* data, qsizetype len) {
+  if (len < 1 || data[0] > 16)
+    return -1;
+  const qsizetype res = 1 + data[0] * 16;
+  return res <= len ? res : -1;
+}
+
+// Differences of the last, incomplete block are decoded here and only the needed samples are copied.
+template <typename BlockDecoder> qsizetype decodeBlocks(const uchar* data, qsizetype len, ushort* samples, qsizetype count, BlockDecoder decodeBlock) {
+  ushort previous = 0;
+  qsizetype pos = 0;
+  for (qsizetype start = 0; start < count; start += blockSize) {
+    const qsizetype blockLen = blockLength(data + pos, len - pos);
+    if (blockLen < 0)
+      return -1;
+
+    if (count - start >= blockSize) {
+      previous = decodeBlock(data + pos, samples + start, previous);
+    } else {
+      ushort last[blockSize];
+      decodeBlock(data + pos, last, previous);
+      memcpy(samples + start, last, (count - start) * sizeof(ushort));
+    }
+    pos += blockLen;
+  }
+  return pos;
+}
+
+ushort decodeBlockScalar(const uchar* block, ushort* out, ushort previous) {
+  const uint bits = block[0];
+  const uint mask = (1u << bits) - 1;
+  ushort deltas[blockSize];
+  for (qsizetype lane = 0; lane < lanes; lane++)
+    for (qsizetype row = 0; row < blockSize / lanes; row++) {
+      if (!bits) {
+        deltas[row * lanes + lane] = 0;
+        continue;
+      }
+      const uint bit = row * bits, word = bit >> 4, shift = bit & 15;
+      uint value = wordAt(block, word, lane) >> shift;
+      if (shift + bits > 16)
+        value |= wordAt(block, word + 1, lane) << (16 - shift);
+      deltas[row * lanes + lane] = unzigzag(static_cast<ushort>(value & mask));
+    }
+
+  for (qsizetype i = 0; i < blockSize; i++)
+    out[i] = previous = static_cast<ushort>(previous + deltas[i]);
+  return previous;
+}
+
+#if defined(WAVEFORMCODEC_SSE2)
+ushort decodeBlockSse2(const uchar* block, ushort* out, ushort previous) {
+  const uint bits = block[0];
+  const __m128i* rows = reinterpret_cast<const __m128i*>(block + 1);
+  const __m128i mask = _mm_set1_epi16(static_cast<short>((1u << bits) - 1)), one = _mm_set1_epi16(1), zero = _mm_setzero_si128();
+  __m128i prev = _mm_set1_epi16(static_cast<short>(previous));
+
+  for (qsizetype row = 0; row < blockSize / lanes; row++) {
+    __m128i v = zero;
+    if (bits) {
+      const uint bit = row * bits, word = bit >> 4, shift = bit & 15;
+      v = _mm_srl_epi16(_mm_loadu_si128(rows + word), _mm_cvtsi32_si128(shift));
+      if (shift + bits > 16)
+        v = _mm_or_si128(v, _mm_sll_epi16(_mm_loadu_si128(rows + word + 1), _mm_cvtsi32_si128(16 - shift)));
+      v = _mm_and_si128(v, mask);
+      v = _mm_xor_si128(_mm_srli_epi16(v, 1), _mm_sub_epi16(zero, _mm_and_si128(v, one))); // zigzag decoding
+    }
+
+    // prefix sum of the eight differences, then the last sample of the previous row is added to all of them
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi16(v, prev);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + row * lanes), v);
+    prev = _mm_shufflehi_epi16(v, 0xFF);
+    prev = _mm_unpackhi_epi64(prev, prev);
+  }
+  return out[blockSize - 1];
+}
+#endif
+} // namespace
+
+qsizetype encode(const ushort* samples, qsizetype count, uchar* out) {
+  ushort previous = 0;
+  qsizetype pos = 0;
+  for (qsizetype start = 0; start < count; start += blockSize) {
+    ushort values[blockSize] = {};
+    uint all = 0;
+    for (qsizetype i = 0; i < qMin(blockSize, count - start); i++) {
+      values[i] = zigzag(static_cast<ushort>(samples[start + i] - previous));
+      previous = samples[start + i];
+      all |= values[i];
+    }
+
+    uint bits = 0;
+    while (all >> bits)
+      bits++;
+
+    uchar* block = out + pos;
+    block[0] = static_cast<uchar>(bits);
+    memset(block + 1, 0, bits * 16);
+    for (qsizetype lane = 0; lane < lanes; lane++)
+      for (qsizetype row = 0; row < blockSize / lanes; row++) {
+        const uint value = values[row * lanes + lane], bit = row * bits, word = bit >> 4, shift = bit & 15;
+        const uint shifted = value << shift; // up to 31 bits, spills into the next word of the lane
+        uchar* w = block + 1 + word * 16 + lane * 2;
+        w[0] |= shifted & 0xFF;
+        w[1] |= (shifted >> 8) & 0xFF;
+        if (shift + bits > 16) {
+          w[16] |= (shifted >> 16) & 0xFF;
+          w[17] |= (shifted >> 24) & 0xFF;
+        }
+      }
+    pos += 1 + bits * 16;
+  }
+  return pos;
+}
+
+qsizetype decodeScalar(const uchar* data, qsizetype len, ushort* samples, qsizetype count) { return decodeBlocks(data, len, samples, count, decodeBlockScalar); }
+
+#if defined(WAVEFORMCODEC_SSE2)
+qsizetype decodeSimd(const uchar* data, qsizetype len, ushort* samples, qsizetype count) { return decodeBlocks(data, len, samples, count, decodeBlockSse2); }
+
+bool simdSupported() { return true; } // SSE2 is a part of every x86-64 CPU
+#else
+qsizetype decodeSimd(const uchar* data, qsizetype len, ushort* samples, qsizetype count) { return decodeScalar(data, len, samples, count); }
+
+bool simdSupported() { return false; }
+#endif
+
+qsizetype decode(const uchar* data, qsizetype len, ushort* samples, qsizetype count) {
+#if defined(WAVEFORMCODEC_SSE2)
+  return decodeSimd(data, len, samples, count);
+#else
+  return decodeScalar(data, len, samples, count);
+#endif
+}
+} // namespace WaveformCodec
@@ -0,0 +1,27 @@
+#ifndef WAVEFORMCODEC_H
+#define WAVEFORMCODEC_H
+
+#include <QtGlobal>
+
+// Lossless compression of 16-bit sample series. Neighbouring samples of a waveform differ very little, so the differences
+// are stored instead of the samples, zigzag-encoded (small negative and positive values become small unsigned ones)
+// and bit-packed with the width needed by the largest one in each block of 128 samples.
+// A block is one byte of bit width b followed by b rows of eight 16-bit little-endian words. Sample r * 8 + l of the block
+// is in lane l, at bit r * b of the lane's 16 * b bits, so a row of eight samples is unpacked with a few vector shifts.
+// The last block is padded with zero differences, the number of samples must be stored by the caller.
+namespace WaveformCodec {
+constexpr qsizetype blockSize = 128;
+constexpr qsizetype lanes = 8;
+
+constexpr qsizetype maxEncodedSize(qsizetype count) { return (count + blockSize - 1) / blockSize * (1 + blockSize * 2); }
+
+qsizetype encode(const ushort* samples, qsizetype count, uchar* out); // returns the encoded size, out must have maxEncodedSize(count) bytes
+
+// Return the number of bytes used, or -1 if the data is too short or damaged.
+qsizetype decodeScalar(const uchar* data, qsizetype len, ushort* samples, qsizetype count);
+qsizetype decodeSimd(const uchar* data, qsizetype len, ushort* samples, qsizetype count); // requires simdSupported()
+bool simdSupported();
+qsizetype decode(const uchar* data, qsizetype len, ushort* samples, qsizetype count); // uses the fastest decoder
+} // namespace WaveformCodec
+
+#endif // WAVEFORMCODEC_H
@@ -0,0 +1,137 @@
+#include "WaveformOverlay.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr qsizetype progressStep = 4096; // band points computed between the progress reports
+
+// Linear interpolation between the closest ranks, the order of the values is changed.
+double percentile(double* values, qsizetype count, double percent) {
+  const double rank = qBound(0.0, percent, 100.0) / 100.0 * (count - 1);
+  const qsizetype below = static_cast<qsizetype>(rank);
+  std::nth_element(values, values + below, values + count);
+  if (below + 1 >= count)
+    return values[below];
+  const double above = *std::min_element(values + below + 1, values + count); // everything after the nth element is not lower than it
+  return values[below] + (above - values[below]) * (rank - below);
+}
+
+// Voltage (in sample units) at any time inside the waveform, between the samples it's interpolated linearly.
+double sampleAt(const Waveform& waveform, double time) {
+  const double pos = time * 1e6 / waveform.timebase().sampleIntervalUs;
+  if (waveform.size() < 2)
+    return waveform.sample(0);
+  const qsizetype i = qBound(qsizetype(0), static_cast<qsizetype>(std::floor(pos)), waveform.size() - 2);
+  const double fraction = qBound(0.0, pos - i, 1.0);
+  return waveform.sample(i) + (waveform.sample(i + 1) - waveform.sample(i)) * fraction;
+}
+
+ushort toSample(double value) { return static_cast<ushort>(qBound(0.0, std::round(value), 65535.0)); }
+} // namespace
+
+qsizetype WaveformOverlay::crankingStart(const Waveform& waveform, const Parameters& parameters) {
+  const qsizetype count = waveform.size();
+  if (count == 0)
+    return 0;
+
+  const quint32 intervalUs = qMax(waveform.timebase().sampleIntervalUs, quint32(1));
+  const qsizetype resting = qBound(qsizetype(1), static_cast<qsizetype>(parameters.restingDuration * 1e6 / intervalUs), count);
+  const ushort* samples = waveform.constData();
+  quint64 sum = 0;
+  for (qsizetype i = 0; i < resting; i++)
+    sum += samples[i];
+
+  const double threshold = static_cast<double>(sum) / resting - parameters.crankingDrop * Waveform::unitsPerVolt;
+  for (qsizetype i = 0; i < count; i++)
+    if (samples[i] < threshold)
+      return i;
+  return 0; // the engine wasn't started during the test, it's shown as it is
+}
+
+void WaveformOverlay::clear() {
+  memberList.clear();
+  bandSeries = Band();
+  startTime = endTime = interval = 0.0;
+}
+
+void WaveformOverlay::add(qint64 timestampMs, const QString& device, const Waveform& waveform, const Parameters& parameters) {
+  if (waveform.isEmpty() || waveform.timebase().sampleIntervalUs == 0)
+    return;
+
+  Member member;
+  member.timestampMs = timestampMs;
+  member.device = device;
+  member.series.waveform = waveform; // samples are shared, not copied
+  member.series.pyramid.update(waveform);
+  member.series.offset = waveform.timeAt(crankingStart(waveform, parameters));
+
+  const double start = -member.series.offset, end = waveform.duration() - member.series.offset;
+  const double sampleInterval = waveform.timebase().sampleIntervalUs / 1e6;
+  startTime = memberList.isEmpty() ? start : qMin(startTime, start);
+  endTime = memberList.isEmpty() ? end : qMax(endTime, end);
+  interval = memberList.isEmpty() ? sampleInterval : qMin(interval, sampleInterval);
+  memberList.append(member);
+  bandSeries = Band(); // describes the previous tests only
+}
+
+bool WaveformOverlay::computeBand(const Parameters& parameters, const Export::ProgressCallback& progress) {
+  bandSeries = Band();
+  if (!parameters.band || memberList.size() < 2)
+    return true;
+
+  // only where every test has samples, otherwise the band would jump where the shorter tests end
+  double from = -memberList.first().series.offset, to = memberList.first().series.waveform.duration() - memberList.first().series.offset;
+  quint32 intervalUs = memberList.first().series.waveform.timebase().sampleIntervalUs;
+  for (const Member& m : memberList) {
+    from = qMax(from, -m.series.offset);
+    to = qMin(to, m.series.waveform.duration() - m.series.offset);
+    intervalUs = qMin(intervalUs, m.series.waveform.timebase().sampleIntervalUs);
+  }
+  if (to <= from)
+    return true;
+
+  const Timebase grid{intervalUs};
+  const qsizetype points = static_cast<qsizetype>(std::floor((to - from) * 1e6 / intervalUs + 1e-6)) + 1; // times are sums of rounded values
+  QVector<ushort> mean(points), low(points), high(points);
+  QVector<double> values(memberList.size());
+  for (qsizetype p = 0; p < points; p++) {
+    if (progress && p % progressStep == 0 && !progress(p, points))
+      return false;
+
+    const double time = from + grid.timeAt(p);
+    double sum = 0.0;
+    for (qsizetype i = 0; i < memberList.size(); i++) {
+      const Series& s = memberList[i].series;
+      values[i] = sampleAt(s.waveform, time + s.offset);
+      sum += values[i];
+    }
+    mean[p] = toSample(sum / values.size());
+    low[p] = toSample(percentile(values.data(), values.size(), parameters.lowPercentile));
+    high[p] = toSample(percentile(values.data(), values.size(), parameters.highPercentile));
+  }
+
+  const auto setSeries = [&](Series& series, const QVector<ushort>& samples) {
+    series.waveform = Waveform(grid);
+    series.waveform.append(samples);
+    series.pyramid.update(series.waveform);
+    series.offset = -from;
+  };
+  setSeries(bandSeries.mean, mean);
+  setSeries(bandSeries.low, low);
+  setSeries(bandSeries.high, high);
+  return !progress || progress(points, points);
+}
+
+WaveformPyramid::Range WaveformOverlay::range(double fromTime, double toTime) const {
+  WaveformPyramid::Range res;
+  for (const Member& m : memberList) {
+    const Series& s = m.series;
+    const double sampleInterval = s.waveform.timebase().sampleIntervalUs / 1e6;
+    const qsizetype first = qBound(qsizetype(0), static_cast<qsizetype>(std::floor((fromTime + s.offset) / sampleInterval)), s.waveform.size());
+    const qsizetype last = qBound(first, static_cast<qsizetype>(std::ceil((toTime + s.offset) / sampleInterval)) + 1, s.waveform.size());
+    if (first < last)
+      res.merge(s.pyramid.range(s.waveform, first, last));
+  }
+  return res;
+}
@@ -0,0 +1,71 @@
+#ifndef WAVEFORMOVERLAY_H
+#define WAVEFORMOVERLAY_H
+
+#include <QString>
+#include <QVector>
+
+#include "Export.h"
+#include "Waveform.h"
+#include "WaveformPyramid.h"
+
+// Several tests on shared axes, shifted in time so that cranking starts at 0 s in all of them, with the mean and a percentile band
+// of their voltages. Every waveform has its own pyramid, so drawing costs the same per test for any length and any zoom.
+// Built in a worker thread and then handed over to the view, it's never changed while it's shown.
+class WaveformOverlay {
+public:
+  struct Parameters {
+    double restingDuration = 0.05; // beginning of the test used as the resting voltage, s
+    double crankingDrop = 0.5;     // fall below the resting voltage that starts cranking, V
+    double lowPercentile = 10.0;
+    double highPercentile = 90.0;
+    bool band = true;              // mean and percentiles are computed only when they are shown
+  };
+
+  // samples are drawn at their time minus the offset
+  struct Series {
+    Waveform waveform;
+    WaveformPyramid pyramid;
+    double offset = 0.0; // s
+  };
+
+  struct Member {
+    qint64 timestampMs = 0;
+    QString device;
+    Series series;
+  };
+
+  // voltages of all the tests sampled on a common grid, over the time covered by every test
+  struct Band {
+    Series mean;
+    Series low;
+    Series high;
+  };
+
+public:
+  static qsizetype crankingStart(const Waveform& waveform, const Parameters& parameters); // index of the first cranking sample, 0 when not found
+
+  void clear();
+  void add(qint64 timestampMs, const QString& device, const Waveform& waveform, const Parameters& parameters);
+  bool computeBand(const Parameters& parameters, const Export::ProgressCallback& progress = nullptr); // false when cancelled
+
+  bool isEmpty() const { return memberList.isEmpty(); }
+  qsizetype size() const { return memberList.size(); }
+  const QVector<Member>& members() const { return memberList; } // in the order they were added, the last one is drawn on top
+  bool hasBand() const { return !bandSeries.mean.waveform.isEmpty(); }
+  const Band& band() const { return bandSeries; }
+
+  // shared axes, valid only for a non-empty overlay
+  double minTime() const { return startTime; }
+  double maxTime() const { return endTime; }
+  double sampleInterval() const { return interval; } // s, the shortest one of all the tests
+  WaveformPyramid::Range range(double fromTime, double toTime) const; // extremes of all the tests in the given aligned times
+
+private:
+  QVector<Member> memberList;
+  Band bandSeries;
+  double startTime = 0.0;
+  double endTime = 0.0;
+  double interval = 0.0;
+};
+
+#endif // WAVEFORMOVERLAY_H
@@ -0,0 +1,82 @@
+#include "WaveformPyramid.h"
+
+void WaveformPyramid::clear() {
+  for (QVector<Range>& level : levels)
+    level.clear();
+  depth = 0;
+  processed = 0;
+}
+
+void WaveformPyramid::update(const Waveform& waveform) {
+  const qsizetype count = waveform.size();
+  if (count < processed)
+    clear();
+  if (count == processed)
+    return;
+
+  // the last block of every level may be incomplete, so it's summarised again together with the new samples
+  qsizetype firstBlock = processed / factor;
+  qsizetype blocks = (count + factor - 1) / factor;
+  const ushort* samples = waveform.constData();
+  const int previousDepth = depth;
+  int n = 0;
+  for (; blocks > 1 || n == 0; n++) {
+    if (n == levels.size())
+      levels.append(QVector<Range>());
+    QVector<Range>& level = levels[n];
+    level.resize(blocks);
+
+    // a level that didn't exist before summarises the already processed samples too
+    for (qsizetype b = (n < previousDepth) ? firstBlock : 0; b < blocks; b++) {
+      Range r;
+      if (n == 0) {
+        const qsizetype end = qMin((b + 1) * factor, count);
+        for (qsizetype i = b * factor; i < end; i++) {
+          r.low = qMin(r.low, samples[i]);
+          r.high = qMax(r.high, samples[i]);
+        }
+      } else {
+        const QVector<Range>& below = levels[n - 1];
+        const qsizetype end = qMin((b + 1) * factor, below.size());
+        for (qsizetype i = b * factor; i < end; i++)
+          r.merge(below[i]);
+      }
+      level[b] = r;
+    }
+
+    firstBlock /= factor;
+    blocks = (blocks + factor - 1) / factor;
+  }
+  depth = n;
+  processed = count;
+}
+
+// Walks from first to last taking the largest aligned block that fits, going up a level when the position becomes aligned to a bigger block
+// and down when the remaining range is shorter than the current block. At most factor blocks are taken on each level on the way up and down.
+WaveformPyramid::Range WaveformPyramid::range(const Waveform& waveform, qsizetype first, qsizetype last) const {
+  Range r;
+  first = qMax(first, qsizetype(0));
+  last = qMin(last, processed);
+  const ushort* samples = waveform.constData();
+
+  int level = -1; // raw samples
+  qsizetype blockSize = 1;
+  while (first < last) {
+    while (level + 1 < depth && first % (blockSize * factor) == 0 && first + blockSize * factor <= last) {
+      level++;
+      blockSize *= factor;
+    }
+    while (first + blockSize > last) {
+      level--;
+      blockSize /= factor;
+    }
+
+    if (level < 0) {
+      r.low = qMin(r.low, samples[first]);
+      r.high = qMax(r.high, samples[first]);
+    } else
+      r.merge(levels[level][first / blockSize]);
+    first += blockSize;
+  }
+  return r;
+}
@@ -0,0 +1,43 @@
+#ifndef WAVEFORMPYRAMID_H
+#define WAVEFORMPYRAMID_H
+
+#include <QVector>
+
+#include "Waveform.h"
+
+// Minimum and maximum of blocks of samples at several levels of detail, each level summarising 4 blocks of the level below.
+// Extremes of any range of samples are then found by looking at a few blocks per level, so drawing a pixel column costs the same
+// for a 1 s test and for an hour long recording. Takes a third of the memory of the samples.
+class WaveformPyramid {
+public:
+  static constexpr qsizetype factor = 4; // blocks of level n hold factor^(n+1) samples
+
+  struct Range {
+    ushort low = std::numeric_limits<ushort>::max();
+    ushort high = 0;
+
+    bool isEmpty() const { return low > high; }
+    void merge(const Range& other) {
+      low = qMin(low, other.low);
+      high = qMax(high, other.high);
+    }
+  };
+
+public:
+  void clear(); // keeps the allocated memory
+  // Summarises the samples appended to the waveform since the last call, so a waveform being received is updated in O(new samples).
+  // A waveform shorter than the previous one is treated as a new one.
+  void update(const Waveform& waveform);
+  // Extremes of samples [first, last) of the waveform given to update(), exact, in O(levels * factor) time.
+  Range range(const Waveform& waveform, qsizetype first, qsizetype last) const;
+
+  qsizetype size() const { return processed; }
+  int levelCount() const { return depth; }
+
+private:
+  QVector<QVector<Range>> levels; // levels above depth are left from a longer waveform and not used
+  int depth = 0;
+  qsizetype processed = 0;
+};
+
+#endif // WAVEFORMPYRAMID_H
@@ -0,0 +1,258 @@
+#include "WaveformRenderer.h"
+
+#include <QPolygonF>
+
+#include <cmath>
+
+namespace {
+constexpr qreal pointsPerInch = 72.0;
+constexpr int maxTicksX = 10;
+constexpr int maxTicksY = 8;
+constexpr qreal olderTestsOpacity = 0.35;
+constexpr qreal olderTestsLineWidth = 0.75; // of the line width
+
+struct SampleSpan {
+  qsizetype first;
+  qsizetype last; // exclusive
+};
+
+// samples in the given time, with one more on each side, so the line reaches the edges of the plot
+SampleSpan visibleSamples(const Waveform& waveform, double minTime, double maxTime) {
+  const double interval = waveform.timebase().sampleIntervalUs / 1e6;
+  const qsizetype first = qBound(qsizetype(0), static_cast<qsizetype>(std::floor(minTime / interval)), waveform.size() - 1);
+  const qsizetype last = qBound(first, static_cast<qsizetype>(std::ceil(maxTime / interval)) + 1, waveform.size() - 1) + 1;
+  return SampleSpan{first, last};
+}
+
+// Distance between the ticks: 1, 2 or 5 times a power of 10, so the labels are round numbers.
+double tickStep(double range, int maxTicks) {
+  const double raw = range / maxTicks;
+  const double magnitude = std::pow(10.0, std::floor(std::log10(raw)));
+  for (const double m : {1.0, 2.0, 5.0})
+    if (m * magnitude >= raw)
+      return m * magnitude;
+  return 10.0 * magnitude;
+}
+
+// enough decimals to tell the ticks apart, at least the given number
+int decimals(double step, int minimum) { return qMax(minimum, static_cast<int>(std::ceil(-std::log10(step) - 1e-9))); }
+} // namespace
+
+WaveformRenderer::WaveformRenderer(const Style& style) : chartStyle(style) {}
+
+WaveformRenderer::Viewport WaveformRenderer::fullViewport(const Waveform& waveform) {
+  Viewport viewport;
+  viewport.maxTime = waveform.isEmpty() || waveform.duration() <= 0.0 ? 1.0 : waveform.duration();
+  viewport.minVoltage = waveform.isEmpty() ? 0.0 : std::floor(waveform.minVoltage());
+  viewport.maxVoltage = waveform.isEmpty() ? 1.0 : std::ceil(waveform.maxVoltage());
+  if (viewport.maxVoltage <= viewport.minVoltage)
+    viewport.maxVoltage = viewport.minVoltage + 1.0;
+  return viewport;
+}
+
+WaveformRenderer::Viewport WaveformRenderer::fullViewport(const WaveformOverlay& overlay) {
+  Viewport viewport;
+  if (overlay.isEmpty())
+    return viewport;
+  viewport.minTime = overlay.minTime();
+  viewport.maxTime = overlay.maxTime() > overlay.minTime() ? overlay.maxTime() : overlay.minTime() + 1.0;
+  const WaveformPyramid::Range r = overlay.range(viewport.minTime, viewport.maxTime);
+  viewport.minVoltage = std::floor(r.low / Waveform::unitsPerVolt);
+  viewport.maxVoltage = std::ceil(r.high / Waveform::unitsPerVolt);
+  if (viewport.maxVoltage <= viewport.minVoltage)
+    viewport.maxVoltage = viewport.minVoltage + 1.0;
+  return viewport;
+}
+
+void WaveformRenderer::render(QPainter& painter, const QRectF& target, const Waveform& waveform) const { render(painter, target, waveform, fullViewport(waveform)); }
+
+QRectF WaveformRenderer::plotArea(const QPaintDevice* device, const QRectF& target, const Viewport& viewport) const {
+  const qreal pt = device->logicalDpiY() / pointsPerInch;
+  const QFontMetricsF fm(chartStyle.font, device);
+  const qreal gap = 4.0 * pt;
+  const int decimalsY = decimals(tickStep(viewport.maxVoltage - viewport.minVoltage, maxTicksY), 2);
+  const qreal labelWidthY = qMax(fm.horizontalAdvance(QString::number(viewport.minVoltage, 'f', decimalsY)), fm.horizontalAdvance(QString::number(viewport.maxVoltage, 'f', decimalsY)));
+  const qreal labelWidthX = fm.horizontalAdvance(QString::number(viewport.maxTime, 'f', decimals(tickStep(viewport.maxTime - viewport.minTime, maxTicksX), 1)));
+  return target.adjusted(gap + fm.height() + gap + labelWidthY + gap, gap + fm.height() * 1.5 + gap, -(gap + labelWidthX / 2), -(gap + fm.height() + gap + fm.height() + gap));
+}
+
+void WaveformRenderer::render(QPainter& painter, const QRectF& target, const Waveform& waveform, const Viewport& viewport, const WaveformPyramid* pyramid) const {
+  painter.save();
+  const QRectF plot = drawFrame(painter, target, viewport);
+  if (!plot.isEmpty() && !waveform.isEmpty()) {
+    const qreal pt = painter.device()->logicalDpiY() / pointsPerInch;
+    painter.setClipRect(plot);
+    painter.setPen(QPen(chartStyle.line, chartStyle.lineWidth * pt, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    drawLine(painter, plot, waveform, viewport, pyramid);
+  }
+  painter.restore();
+}
+
+void WaveformRenderer::render(QPainter& painter, const QRectF& target, const WaveformOverlay& overlay, const Viewport& viewport) const {
+  painter.save();
+  const QRectF plot = drawFrame(painter, target, viewport);
+  if (!plot.isEmpty() && !overlay.isEmpty()) {
+    const qreal pt = painter.device()->logicalDpiY() / pointsPerInch;
+    painter.setClipRect(plot);
+    if (overlay.hasBand())
+      drawBand(painter, plot, overlay.band(), viewport);
+
+    const QVector<WaveformOverlay::Member>& members = overlay.members();
+    QColor older = chartStyle.line;
+    older.setAlphaF(olderTestsOpacity);
+    painter.setPen(QPen(older, chartStyle.lineWidth * olderTestsLineWidth * pt, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    for (qsizetype i = 0; i < members.size() - 1; i++)
+      drawSeries(painter, plot, members[i].series, viewport);
+    if (overlay.hasBand()) {
+      painter.setPen(QPen(chartStyle.mean, chartStyle.lineWidth * pt, Qt::DashLine, Qt::RoundCap, Qt::RoundJoin));
+      drawSeries(painter, plot, overlay.band().mean, viewport);
+    }
+    painter.setPen(QPen(chartStyle.line, chartStyle.lineWidth * pt, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+    drawSeries(painter, plot, members.last().series, viewport);
+  }
+  painter.restore();
+}
+
+QRectF WaveformRenderer::drawFrame(QPainter& painter, const QRectF& target, const Viewport& viewport) const {
+  const qreal pt = painter.device()->logicalDpiY() / pointsPerInch; // device units in one point
+  const QFontMetricsF fm(chartStyle.font, painter.device());
+  const qreal gap = 4.0 * pt;
+
+  painter.fillRect(target, chartStyle.background);
+  painter.setFont(chartStyle.font);
+  painter.setPen(chartStyle.foreground);
+
+  const double minTime = viewport.minTime, maxTime = viewport.maxTime, minVoltage = viewport.minVoltage, maxVoltage = viewport.maxVoltage;
+  const double stepX = tickStep(maxTime - minTime, maxTicksX), stepY = tickStep(maxVoltage - minVoltage, maxTicksY);
+  const int decimalsX = decimals(stepX, 1), decimalsY = decimals(stepY, 2); // labels of the whole test look like in the chart view before
+
+  const QRectF plot = plotArea(painter.device(), target, viewport);
+  if (plot.width() <= 0 || plot.height() <= 0) // target too small for anything but the background
+    return QRectF();
+  const qreal labelWidthY = plot.left() - target.left() - (gap + fm.height() + gap + gap);
+
+  QFont titleFont = chartStyle.font;
+  titleFont.setBold(true);
+  painter.setFont(titleFont);
+  painter.drawText(QRectF(target.left(), target.top() + gap, target.width(), fm.height() * 1.5), Qt::AlignCenter, chartStyle.title);
+  painter.setFont(chartStyle.font);
+
+  const auto mapX = [&](double time) { return plot.left() + (time - minTime) / (maxTime - minTime) * plot.width(); };
+  const auto mapY = [&](double voltage) { return plot.bottom() - (voltage - minVoltage) / (maxVoltage - minVoltage) * plot.height(); };
+
+  // grid with tick labels at round numbers inside the viewport
+  for (double i = std::ceil(minTime / stepX - 1e-9); i * stepX <= maxTime + stepX * 1e-9; i++) {
+    const qreal x = mapX(i * stepX);
+    painter.setPen(QPen(chartStyle.grid, 0.5 * pt));
+    painter.drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+    painter.setPen(chartStyle.foreground);
+    painter.drawText(QRectF(x - plot.width() / 2, plot.bottom() + gap, plot.width(), fm.height()), Qt::AlignHCenter | Qt::AlignTop, QString::number(i * stepX, 'f', decimalsX));
+  }
+  for (double i = std::ceil(minVoltage / stepY - 1e-9); i * stepY <= maxVoltage + stepY * 1e-9; i++) {
+    const double voltage = i * stepY;
+    const qreal y = mapY(voltage);
+    painter.setPen(QPen(chartStyle.grid, 0.5 * pt));
+    painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+    painter.setPen(chartStyle.foreground);
+    painter.drawText(QRectF(plot.left() - gap - labelWidthY, y - fm.height() / 2, labelWidthY, fm.height()), Qt::AlignRight | Qt::AlignVCenter, QString::number(voltage, 'f', decimalsY));
+  }
+
+  painter.setPen(QPen(chartStyle.foreground, 0.75 * pt));
+  painter.drawRect(plot);
+  painter.drawText(QRectF(plot.left(), plot.bottom() + gap + fm.height() + gap, plot.width(), fm.height()), Qt::AlignCenter, chartStyle.labels.time);
+  painter.save();
+  painter.translate(target.left() + gap, plot.center().y());
+  painter.rotate(-90.0);
+  painter.drawText(QRectF(-plot.height() / 2, 0.0, plot.height(), fm.height()), Qt::AlignCenter, chartStyle.labels.voltage);
+  painter.restore();
+  return plot;
+}
+
+QImage WaveformRenderer::renderImage(const Waveform& waveform, const QSize& size, qreal dpi) const {
+  QImage image(size, QImage::Format_RGB32);
+  const int dotsPerMeter = qRound(dpi / 0.0254);
+  image.setDotsPerMeterX(dotsPerMeter);
+  image.setDotsPerMeterY(dotsPerMeter);
+
+  QPainter painter(&image);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  render(painter, QRectF(image.rect()), waveform);
+  return image;
+}
+
+void WaveformRenderer::drawLine(QPainter& painter, const QRectF& plot, const Waveform& waveform, const Viewport& viewport, const WaveformPyramid* pyramid) const {
+  const double xScale = plot.width() / (viewport.maxTime - viewport.minTime), yScale = plot.height() / (viewport.maxVoltage - viewport.minVoltage);
+  const auto mapX = [&](double time) { return plot.left() + (time - viewport.minTime) * xScale; };
+  const auto mapY = [&](double voltage) { return plot.bottom() - (voltage - viewport.minVoltage) * yScale; };
+
+  const auto [first, last] = visibleSamples(waveform, viewport.minTime, viewport.maxTime);
+  const qsizetype count = last - first;
+
+  const qsizetype columns = qMax(qsizetype(plot.width()), qsizetype(1));
+  if (count <= 2 * columns) { // every sample can be seen, draw them all
+    QPolygonF points(count);
+    for (qsizetype i = 0; i < count; i++)
+      points[i] = QPointF(mapX(waveform.timeAt(first + i)), mapY(waveform.voltageAt(first + i)));
+    painter.drawPolyline(points);
+    return;
+  }
+
+  // more samples than the device can show, keep only the extremes of each column, which looks exactly the same but is much faster to draw
+  const ushort* samples = waveform.constData();
+  QPolygonF points(2 * columns);
+  for (qsizetype col = 0; col < columns; col++) {
+    const qsizetype begin = first + col * count / columns, end = first + (col + 1) * count / columns;
+    ushort low = samples[begin], high = samples[begin];
+    if (pyramid != nullptr && pyramid->size() >= end) {
+      const WaveformPyramid::Range r = pyramid->range(waveform, begin, end);
+      low = r.low;
+      high = r.high;
+    } else {
+      for (qsizetype i = begin + 1; i < end; i++) {
+        low = qMin(low, samples[i]);
+        high = qMax(high, samples[i]);
+      }
+    }
+    const qreal x = mapX(waveform.timeAt(begin) + (waveform.timeAt(end - 1) - waveform.timeAt(begin)) / 2);
+    points[2 * col] = QPointF(x, mapY(high / Waveform::unitsPerVolt));
+    points[2 * col + 1] = QPointF(x, mapY(low / Waveform::unitsPerVolt));
+  }
+  painter.drawPolyline(points);
+}
+
+// the series is drawn like a waveform in a viewport moved by its offset
+void WaveformRenderer::drawSeries(QPainter& painter, const QRectF& plot, const WaveformOverlay::Series& series, const Viewport& viewport) const {
+  Viewport shifted = viewport;
+  shifted.minTime += series.offset;
+  shifted.maxTime += series.offset;
+  drawLine(painter, plot, series.waveform, shifted, &series.pyramid);
+}
+
+// Area between the low and the high percentile. Both are sampled on the same grid, so with more samples than columns
+// the lowest low and the highest high of each column keep the outline of the band.
+void WaveformRenderer::drawBand(QPainter& painter, const QRectF& plot, const WaveformOverlay::Band& band, const Viewport& viewport) const {
+  const Waveform& low = band.low.waveform;
+  const Waveform& high = band.high.waveform;
+  const double minTime = viewport.minTime + band.low.offset, maxTime = viewport.maxTime + band.low.offset;
+  const double xScale = plot.width() / (maxTime - minTime), yScale = plot.height() / (viewport.maxVoltage - viewport.minVoltage);
+  const auto mapX = [&](double time) { return plot.left() + (time - minTime) * xScale; };
+  const auto mapY = [&](ushort sample) { return plot.bottom() - (sample / Waveform::unitsPerVolt - viewport.minVoltage) * yScale; };
+
+  const auto [first, last] = visibleSamples(low, minTime, maxTime);
+  const qsizetype count = last - first;
+  const qsizetype columns = qMin(qMax(qsizetype(plot.width()), qsizetype(1)), count);
+  QPolygonF outline(2 * columns);
+  for (qsizetype col = 0; col < columns; col++) {
+    const qsizetype begin = first + col * count / columns, end = first + (col + 1) * count / columns;
+    const qreal x = mapX(low.timeAt(begin) + (low.timeAt(end - 1) - low.timeAt(begin)) / 2);
+    outline[col] = QPointF(x, mapY(band.high.pyramid.range(high, begin, end).high));
+    outline[2 * columns - 1 - col] = QPointF(x, mapY(band.low.pyramid.range(low, begin, end).low));
+  }
+
+  painter.save();
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(chartStyle.band);
+  painter.drawPolygon(outline);
+  painter.restore();
+}
@@ -0,0 +1,64 @@
+#ifndef WAVEFORMRENDERER_H
+#define WAVEFORMRENDERER_H
+
+#include <QFont>
+#include <QImage>
+#include <QPainter>
+
+#include "Export.h"
+#include "Waveform.h"
+#include "WaveformOverlay.h"
+#include "WaveformPyramid.h"
+
+// Draws the waveform chart (title, axes, grid, tick labels and the voltage line) with QPainter, without any widget.
+// All sizes are given in points and converted with the resolution of the paint device, so the result looks the same
+// on a small preview, a high resolution image and a PDF page. QImage and QPdfWriter targets can be used from any thread.
+class WaveformRenderer {
+public:
+  struct Style {
+    QString title = QStringLiteral("Battery voltage during cranking");
+    Export::WaveformLabels labels;
+    QFont font = QFont(QString(), 9); // family of the application by default, size in points
+    qreal lineWidth = 1.0;            // in points
+    QColor background = Qt::white;
+    QColor foreground = Qt::black;    // text and axes
+    QColor grid = QColor(0xD0, 0xD0, 0xD0);
+    QColor line = QColor(0x20, 0x9F, 0xDF);
+    QColor band = QColor(0x20, 0x9F, 0xDF, 0x40); // percentiles of overlaid tests
+    QColor mean = QColor(0xDF, 0x60, 0x20);       // mean of overlaid tests
+  };
+
+  // visible part of the waveform, in seconds and volts
+  struct Viewport {
+    double minTime = 0.0;
+    double maxTime = 1.0;
+    double minVoltage = 0.0;
+    double maxVoltage = 1.0;
+  };
+
+  explicit WaveformRenderer(const Style& style = Style());
+
+public:
+  const Style& style() const { return chartStyle; }
+  static Viewport fullViewport(const Waveform& waveform); // the whole test in time and whole volts around the measured voltage
+  static Viewport fullViewport(const WaveformOverlay& overlay);
+
+  void render(QPainter& painter, const QRectF& target, const Waveform& waveform) const; // target is in the logical coordinates of the painter
+  // With a pyramid of the waveform, drawing costs the same for any number of samples, so it's used for zooming and panning on the screen.
+  void render(QPainter& painter, const QRectF& target, const Waveform& waveform, const Viewport& viewport, const WaveformPyramid* pyramid = nullptr) const;
+  // Older tests are drawn fainter under the band and the mean, the newest one on top in the color of a single test.
+  void render(QPainter& painter, const QRectF& target, const WaveformOverlay& overlay, const Viewport& viewport) const;
+  QImage renderImage(const Waveform& waveform, const QSize& size, qreal dpi = 96.0) const; // size in pixels, dpi scales the text and lines
+  QRectF plotArea(const QPaintDevice* device, const QRectF& target, const Viewport& viewport) const; // part of the target with the waveform
+
+private:
+  QRectF drawFrame(QPainter& painter, const QRectF& target, const Viewport& viewport) const; // returns the plot area, empty when there is no room for it
+  void drawLine(QPainter& painter, const QRectF& plot, const Waveform& waveform, const Viewport& viewport, const WaveformPyramid* pyramid) const;
+  void drawSeries(QPainter& painter, const QRectF& plot, const WaveformOverlay::Series& series, const Viewport& viewport) const;
+  void drawBand(QPainter& painter, const QRectF& plot, const WaveformOverlay::Band& band, const Viewport& viewport) const;
+
+private:
+  Style chartStyle;
+};
+
+#endif // WAVEFORMRENDERER_H
@@ -0,0 +1,191 @@
+#include "WaveformView.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QWheelEvent>
+
+#include <cmath>
+
+#include "Trace.h"
+
+WaveformView::WaveformView(QWidget* parent) : QWidget{parent} {
+  setAttribute(Qt::WA_OpaquePaintEvent); // renderer fills the whole widget
+  setFocusPolicy(Qt::WheelFocus);
+}
+
+void WaveformView::setChartStyle(const WaveformRenderer::Style& style) {
+  renderer = WaveformRenderer(style);
+  update();
+}
+
+void WaveformView::setWaveform(const Waveform& waveform) {
+  if (data.timebase().sampleIntervalUs != waveform.timebase().sampleIntervalUs)
+    data = Waveform(waveform.timebase());
+  data.clear(); // memory of the previous waveform is reused
+  data.append(waveform.samples());
+  pyramid.clear();
+  pyramid.update(data);
+  live = false;
+  if (!isShowingOverlay()) // zoom of the overlay is kept
+    resetZoom();
+}
+
+void WaveformView::updateLive(const Waveform& waveform) {
+  if (!live || waveform.size() < data.size()) {
+    if (data.timebase().sampleIntervalUs != waveform.timebase().sampleIntervalUs)
+      data = Waveform(waveform.timebase());
+    data.clear();
+    pyramid.clear();
+    live = true;
+    if (!isShowingOverlay())
+      zoomed = false;
+  }
+
+  data.append(waveform.constData() + data.size(), waveform.size() - data.size());
+  pyramid.update(data); // only the new samples are summarised
+  if (isShowingOverlay())
+    return; // the viewport belongs to the overlay
+  if (zoomed)
+    fitVoltage();
+  else
+    setTimeRange(0.0, totalDuration());
+  update();
+}
+
+void WaveformView::clear() {
+  data.clear();
+  pyramid.clear();
+  live = false;
+  if (!isShowingOverlay())
+    resetZoom();
+}
+
+void WaveformView::resetZoom() {
+  zoomed = false;
+  setTimeRange(startTime(), endTime());
+  update();
+}
+
+void WaveformView::setOverlay(WaveformOverlay newOverlay) {
+  overlay = std::move(newOverlay);
+  resetZoom();
+}
+
+void WaveformView::clearOverlay() {
+  overlay.clear();
+  resetZoom();
+}
+
+// While the waveform is received, the time axis grows in whole seconds, so it doesn't change with every update.
+double WaveformView::totalDuration() const {
+  const double duration = data.duration();
+  if (live)
+    return qMax(std::ceil(duration), 1.0);
+  return duration > 0.0 ? duration : 1.0;
+}
+
+void WaveformView::setTimeRange(double minTime, double maxTime) {
+  const double start = startTime(), total = endTime() - start;
+  const double minSpan = minVisibleSamples * (isShowingOverlay() ? overlay.sampleInterval() : data.timebase().sampleIntervalUs / 1e6);
+  double span = qBound(qMin(minSpan, total), maxTime - minTime, total);
+  minTime = qBound(start, minTime, start + total - span);
+  viewport.minTime = minTime;
+  viewport.maxTime = minTime + span;
+  fitVoltage();
+}
+
+// whole volts around the visible samples, like the chart of the whole waveform
+void WaveformView::fitVoltage() {
+  WaveformPyramid::Range visible;
+  if (isShowingOverlay()) {
+    visible = overlay.range(viewport.minTime, viewport.maxTime);
+  } else {
+    const double interval = data.timebase().sampleIntervalUs / 1e6;
+    const qsizetype first = static_cast<qsizetype>(std::floor(viewport.minTime / interval));
+    const qsizetype last = static_cast<qsizetype>(std::ceil(viewport.maxTime / interval)) + 1;
+    visible = pyramid.range(data, first, last);
+  }
+  if (visible.isEmpty()) {
+    viewport.minVoltage = 0.0;
+    viewport.maxVoltage = 1.0;
+    return;
+  }
+
+  viewport.minVoltage = std::floor(visible.low / Waveform::unitsPerVolt);
+  viewport.maxVoltage = std::ceil(visible.high / Waveform::unitsPerVolt);
+  if (viewport.maxVoltage <= viewport.minVoltage)
+    viewport.maxVoltage = viewport.minVoltage + 1.0;
+}
+
+void WaveformView::paintEvent(QPaintEvent* event) {
+  Q_UNUSED(event);
+  const Trace::Span span("WaveformView::paintEvent");
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  if (isShowingOverlay())
+    renderer.render(painter, QRectF(rect()), overlay, viewport);
+  else
+    renderer.render(painter, QRectF(rect()), data, viewport, &pyramid);
+}
+
+void WaveformView::wheelEvent(QWheelEvent* event) {
+  const QRectF plot = renderer.plotArea(this, QRectF(rect()), viewport);
+  const double steps = event->angleDelta().y() / 120.0;
+  if ((data.isEmpty() && !isShowingOverlay()) || plot.width() <= 0 || steps == 0.0) {
+    event->ignore();
+    return;
+  }
+
+  // time under the cursor stays in place
+  const double span = viewport.maxTime - viewport.minTime;
+  const double anchor = qBound(0.0, (event->position().x() - plot.left()) / plot.width(), 1.0);
+  const double anchorTime = viewport.minTime + anchor * span;
+  const double newSpan = span * std::pow(zoomStep, steps);
+  setTimeRange(anchorTime - anchor * newSpan, anchorTime + (1.0 - anchor) * newSpan);
+  zoomed = viewport.maxTime - viewport.minTime < endTime() - startTime();
+  update();
+  event->accept();
+}
+
+void WaveformView::mousePressEvent(QMouseEvent* event) {
+  if (event->button() != Qt::LeftButton || !zoomed) {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+  dragging = true;
+  dragStart = event->position();
+  dragStartTime = viewport.minTime;
+  setCursor(Qt::ClosedHandCursor);
+}
+
+void WaveformView::mouseMoveEvent(QMouseEvent* event) {
+  if (!dragging) {
+    QWidget::mouseMoveEvent(event);
+    return;
+  }
+  const QRectF plot = renderer.plotArea(this, QRectF(rect()), viewport);
+  if (plot.width() <= 0)
+    return;
+  const double span = viewport.maxTime - viewport.minTime;
+  const double minTime = dragStartTime - (event->position().x() - dragStart.x()) / plot.width() * span;
+  setTimeRange(minTime, minTime + span);
+  update();
+}
+
+void WaveformView::mouseReleaseEvent(QMouseEvent* event) {
+  if (!dragging || event->button() != Qt::LeftButton) {
+    QWidget::mouseReleaseEvent(event);
+    return;
+  }
+  dragging = false;
+  unsetCursor();
+}
+
+void WaveformView::mouseDoubleClickEvent(QMouseEvent* event) {
+  if (event->button() != Qt::LeftButton) {
+    QWidget::mouseDoubleClickEvent(event);
+    return;
+  }
+  resetZoom();
+}
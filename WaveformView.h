@@ -0,0 +1,71 @@
+#ifndef WAVEFORMVIEW_H
+#define WAVEFORMVIEW_H
+
+#include <QWidget>
+
+#include "Waveform.h"
+#include "WaveformOverlay.h"
+#include "WaveformPyramid.h"
+#include "WaveformRenderer.h"
+
+// Waveform chart on the screen. It's drawn by WaveformRenderer from a min/max pyramid of the samples, so a repaint costs the same
+// for a short test and for a long recording, and the chart looks exactly like the exported one.
+// The wheel zooms the time axis around the cursor, dragging pans it and a double click shows the whole waveform again.
+// An overlay of tests from the history can be shown instead of the waveform, which is still updated in the background.
+class WaveformView : public QWidget {
+  Q_OBJECT
+public:
+  explicit WaveformView(QWidget* parent = nullptr);
+
+public:
+  const WaveformRenderer::Style& chartStyle() const { return renderer.style(); }
+  void setChartStyle(const WaveformRenderer::Style& style);
+
+  const Waveform& waveform() const { return data; }
+  void setWaveform(const Waveform& waveform); // copies the samples and shows the whole waveform
+  // Adds the samples appended to the waveform since the last call, the axes grow with it unless the user zoomed in.
+  // A waveform shorter than the shown one is a new one.
+  void updateLive(const Waveform& waveform);
+  void clear();
+  void resetZoom();
+
+  bool isShowingOverlay() const { return !overlay.isEmpty(); }
+  const WaveformOverlay& waveformOverlay() const { return overlay; }
+  void setOverlay(WaveformOverlay newOverlay); // shown on the axes of all its tests, until it's cleared
+  void clearOverlay();
+
+  QSize sizeHint() const override { return QSize(640, 400); }
+  QSize minimumSizeHint() const override { return QSize(200, 120); }
+
+protected:
+  void paintEvent(QPaintEvent* event) override;
+  void wheelEvent(QWheelEvent* event) override;
+  void mousePressEvent(QMouseEvent* event) override;
+  void mouseMoveEvent(QMouseEvent* event) override;
+  void mouseReleaseEvent(QMouseEvent* event) override;
+  void mouseDoubleClickEvent(QMouseEvent* event) override;
+
+private:
+  void setTimeRange(double minTime, double maxTime); // clamped to the waveform, the voltage range follows the visible samples
+  void fitVoltage();
+  double totalDuration() const;
+  double startTime() const { return isShowingOverlay() ? overlay.minTime() : 0.0; } // times before cranking are negative in the overlay
+  double endTime() const { return isShowingOverlay() ? overlay.maxTime() : totalDuration(); }
+
+private:
+  static constexpr double zoomStep = 0.8;       // visible time per wheel step
+  static constexpr qsizetype minVisibleSamples = 16;
+
+  WaveformRenderer renderer;
+  Waveform data;
+  WaveformPyramid pyramid;
+  WaveformOverlay overlay;
+  WaveformRenderer::Viewport viewport;
+  bool live = false;   // waveform is still being received
+  bool zoomed = false; // user chose the visible time, otherwise the whole waveform is shown
+  bool dragging = false;
+  QPointF dragStart;
+  double dragStartTime = 0.0;
+};
+
+#endif // WAVEFORMVIEW_H
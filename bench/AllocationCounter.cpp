@@ -0,0 +1,46 @@
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts every heap allocation of the process. With glibc malloc itself is replaced, so allocations made by Qt containers,
+// which don't use operator new, are counted too. Elsewhere only operator new is counted.
+namespace {
+std::atomic<quint64> allocations{0};
+}
+
+quint64 allocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+}
+#else
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
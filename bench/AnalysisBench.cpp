@@ -0,0 +1,81 @@
+#include "AnalysisBench.h"
+
+#include <QTest>
+
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "WaveformAnalysis.h"
+
+void AnalysisBench::initTestCase() {
+  // the vector kernel must give exactly the same results as the scalar loop, also when the minimum is repeated or the data is noise
+  Waveform noise;
+  for (qsizetype i = 0; i < 70000; i++) {
+    const ushort sample = static_cast<ushort>(i * 40503u ^ (i << 3));
+    noise.append(&sample, 1);
+  }
+
+  for (const Waveform& waveform : {Corpus::crankingWaveform(800), Corpus::crankingWaveform(1001), noise}) {
+    for (const ushort threshold : {ushort(0), ushort(96), ushort(120), ushort(0xFFFF)}) {
+      const WaveformAnalysis::SampleStats scalar = WaveformAnalysis::scanScalar(waveform.constData(), waveform.size(), threshold);
+      const WaveformAnalysis::SampleStats simd = WaveformAnalysis::scanSimd(waveform.constData(), waveform.size(), threshold);
+      QCOMPARE(simd.minSample, scalar.minSample);
+      QCOMPARE(simd.minIndex, scalar.minIndex);
+      QCOMPARE(simd.belowThreshold, scalar.belowThreshold);
+      QCOMPARE(simd.squaredDifferences, scalar.squaredDifferences);
+    }
+  }
+}
+
+void AnalysisBench::addWaveformLengths() {
+  QTest::addColumn<qsizetype>("samples");
+  QTest::newRow("cranking test") << qsizetype(800);
+  QTest::newRow("long recording") << qsizetype(80000);
+}
+
+void AnalysisBench::scanScalar_data() { addWaveformLengths(); }
+
+void AnalysisBench::scanScalar() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  ThroughputCounter counter;
+  volatile qsizetype res = 0;
+
+  QBENCHMARK {
+    res = WaveformAnalysis::scanScalar(waveform.constData(), samples, 96).minIndex;
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
+
+void AnalysisBench::scanSimd_data() { addWaveformLengths(); }
+
+void AnalysisBench::scanSimd() {
+  if (!WaveformAnalysis::simdSupported())
+    QSKIP("SIMD kernel is not available on this CPU");
+
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  ThroughputCounter counter;
+  volatile qsizetype res = 0;
+
+  QBENCHMARK {
+    res = WaveformAnalysis::scanSimd(waveform.constData(), samples, 96).minIndex;
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
+
+void AnalysisBench::analyze_data() { addWaveformLengths(); }
+
+void AnalysisBench::analyze() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  ThroughputCounter counter;
+  volatile double res = 0.0;
+
+  QBENCHMARK {
+    res = WaveformAnalysis::analyze(waveform).minVoltage;
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
@@ -0,0 +1,23 @@
+#ifndef ANALYSISBENCH_H
+#define ANALYSISBENCH_H
+
+#include <QObject>
+
+// Analysis of cranking waveforms, it has to be fast enough to be run again over the whole test history.
+class AnalysisBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void scanScalar_data();
+  void scanScalar();
+  void scanSimd_data();
+  void scanSimd();
+  void analyze_data();
+  void analyze();
+
+private:
+  void addWaveformLengths();
+};
+
+#endif // ANALYSISBENCH_H
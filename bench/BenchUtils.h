@@ -0,0 +1,41 @@
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H
+
+#include <QElapsedTimer>
+
+// Counts the bytes processed inside a QBENCHMARK block, including the warmup passes, and reports the throughput once it's destroyed.
+class ThroughputCounter {
+public:
+  ThroughputCounter() { timer.start(); }
+  ~ThroughputCounter() {
+    const qint64 ns = timer.nsecsElapsed();
+    if (ns > 0)
+      qInfo("throughput: %.1f MB/s", static_cast<double>(processedBytes) * 1000.0 / static_cast<double>(ns));
+  }
+
+  void add(qsizetype bytes) { processedBytes += bytes; }
+
+private:
+  QElapsedTimer timer;
+  quint64 processedBytes = 0;
+};
+
+quint64 allocationCount(); // AllocationCounter.cpp
+
+// Counts the heap allocations made inside a QBENCHMARK block and reports them per decoded frame once it's destroyed.
+class AllocationCounter {
+public:
+  AllocationCounter() : startCount(allocationCount()) {}
+  ~AllocationCounter() {
+    if (frames)
+      qInfo("allocations: %.2f per frame", static_cast<double>(allocationCount() - startCount) / static_cast<double>(frames));
+  }
+
+  void addFrames(qsizetype count) { frames += count; }
+
+private:
+  quint64 startCount;
+  quint64 frames = 0;
+};
+
+#endif // BENCHUTILS_H
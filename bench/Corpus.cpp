@@ -0,0 +1,91 @@
+#include "Corpus.h"
+
+#include <QDir>
+#include <QRandomGenerator>
+
+#include "CaptureFile.h"
+#include "FrameDecoder.h"
+#include "emulator/PacketBuilder.h"
+
+namespace Corpus {
+namespace {
+constexpr quint32 seed = 650;
+}
+
+QByteArray syntheticSession(int tests, qsizetype samplesPerPacket) {
+  QRandomGenerator rng(seed);
+  QByteArray data;
+  for (int i = 0; i < tests; i++) {
+    data += PacketBuilder::battInfo(PacketBuilder::sampleBattInfoText(rng));
+    const QVector<ushort> samples = PacketBuilder::sampleCrankingWaveform(800, rng);
+    for (qsizetype pos = 0; pos < samples.size(); pos += samplesPerPacket)
+      data += PacketBuilder::chart(samples.constData() + pos, qMin(samplesPerPacket, samples.size() - pos));
+    data += PacketBuilder::chartDisplay();
+  }
+  return data;
+}
+
+QByteArray chartPackets(int packets, qsizetype samplesPerPacket) {
+  QRandomGenerator rng(seed);
+  const QVector<ushort> samples = PacketBuilder::sampleCrankingWaveform(samplesPerPacket, rng);
+  const QByteArray packet = PacketBuilder::chart(samples.constData(), samples.size());
+  return packet.repeated(packets);
+}
+
+QByteArray garbage(qsizetype length, uchar headerByteEvery) {
+  QRandomGenerator rng(seed);
+  QByteArray data(length, Qt::Uninitialized);
+  for (qsizetype i = 0; i < length; i++) {
+    uchar b = static_cast<uchar>(rng.bounded(256));
+    if (b == 0x24)
+      b = 0x25;
+    if (headerByteEvery && i % headerByteEvery == 0)
+      b = 0x24; // start of a header that never follows
+    data[i] = static_cast<char>(b);
+  }
+  return data;
+}
+
+QVector<QByteArray> battInfoTexts(int count) {
+  QRandomGenerator rng(seed);
+  QVector<QByteArray> texts;
+  for (int i = 0; i < count; i++)
+    texts.append(PacketBuilder::sampleBattInfoText(rng));
+  return texts;
+}
+
+Waveform crankingWaveform(qsizetype samples) {
+  QRandomGenerator rng(seed);
+  Waveform waveform;
+  waveform.append(PacketBuilder::sampleCrankingWaveform(samples, rng));
+  return waveform;
+}
+
+QByteArray recordedSession() {
+  const QString dir = qEnvironmentVariable("KBTINFO_BENCH_CORPUS");
+  if (dir.isEmpty())
+    return QByteArray();
+
+  QByteArray data;
+  const QFileInfoList files = QDir(dir).entryInfoList({"*.kbtcap"}, QDir::Files, QDir::Name);
+  for (const QFileInfo& file : files) {
+    CaptureReader reader;
+    if (!reader.open(file.filePath()))
+      continue;
+    CaptureReader::Chunk chunk;
+    while (reader.readChunk(chunk))
+      data.append(reinterpret_cast<const char*>(chunk.data), chunk.length);
+  }
+  return data;
+}
+
+qsizetype countFrames(const QByteArray& data) {
+  qsizetype frames = 0;
+  FrameDecoder decoder;
+  QObject::connect(&decoder, &FrameDecoder::battInfoFrameReceived, [&frames]() { frames++; });
+  QObject::connect(&decoder, &FrameDecoder::chartFrameReceived, [&frames]() { frames++; });
+  QObject::connect(&decoder, &FrameDecoder::chartDisplayFrameReceived, [&frames]() { frames++; });
+  decoder.decode(RingBuffer::View{{reinterpret_cast<const uchar*>(data.constData()), data.size()}, {}});
+  return frames;
+}
+} // namespace Corpus
@@ -0,0 +1,25 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "Waveform.h"
+
+// Data the benchmarks are run on. Synthetic data is generated with a fixed seed, so the results can be compared between runs.
+namespace Corpus {
+// Complete tests as the tester sends them: battery info, the waveform split into chart packets and chart display.
+QByteArray syntheticSession(int tests, qsizetype samplesPerPacket = 256);
+QByteArray chartPackets(int packets, qsizetype samplesPerPacket);
+QByteArray garbage(qsizetype length, uchar headerByteEvery = 0); // never contains a header, optionally with lone 0x24 bytes
+QVector<QByteArray> battInfoTexts(int count);
+Waveform crankingWaveform(qsizetype samples);
+
+// Data received in the capture files found in the directory given by KBTINFO_BENCH_CORPUS, empty if there are none.
+QByteArray recordedSession();
+
+// Number of packets in the data, as found by the decoder.
+qsizetype countFrames(const QByteArray& data);
+} // namespace Corpus
+
+#endif // CORPUS_H
@@ -0,0 +1,116 @@
+#include "DecoderBench.h"
+
+#include <QTest>
+
+#include "BattInfo.h"
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "FrameDecoder.h"
+#include "SessionDecoder.h"
+
+namespace {
+// Same steps as SerialPort and SerialWorker do for every read.
+void decodeInReads(FrameDecoder& decoder, RingBuffer& buffer, const QByteArray& data, qsizetype readSize) {
+  const uchar* src = reinterpret_cast<const uchar*>(data.constData());
+  for (qsizetype pos = 0; pos < data.size(); pos += readSize) {
+    buffer.write(src + pos, qMin(readSize, data.size() - pos));
+    buffer.consume(decoder.decode(buffer.view()));
+  }
+}
+} // namespace
+
+void DecoderBench::headerDetection_data() {
+  QTest::addColumn<QByteArray>("data");
+  QTest::newRow("random data") << Corpus::garbage(1024 * 1024);
+  QTest::newRow("lone header bytes") << Corpus::garbage(1024 * 1024, 16);
+}
+
+void DecoderBench::headerDetection() {
+  QFETCH(QByteArray, data);
+  FrameDecoder decoder;
+  RingBuffer buffer(128 * 1024);
+  ThroughputCounter counter;
+
+  QBENCHMARK {
+    decodeInReads(decoder, buffer, data, readSize);
+    counter.add(data.size());
+  }
+}
+
+void DecoderBench::chartDecoding_data() {
+  QTest::addColumn<QByteArray>("data");
+  QTest::addColumn<qsizetype>("frames");
+  for (qsizetype samples : {16, 256, 4096}) {
+    const int packets = static_cast<int>(qMax(qsizetype(1), 1024 * 1024 / (samples * 2)));
+    QTest::newRow(qPrintable(QString("%1 samples per packet").arg(samples))) << Corpus::chartPackets(packets, samples) << qsizetype(packets);
+  }
+}
+
+void DecoderBench::chartDecoding() {
+  QFETCH(QByteArray, data);
+  QFETCH(qsizetype, frames);
+  FrameDecoder decoder;
+  RingBuffer buffer(128 * 1024);
+  qsizetype samples = 0;
+  QObject::connect(&decoder, &FrameDecoder::chartFrameReceived, [&samples](const RingBuffer::View& view) { samples += view.length() / 2; });
+  ThroughputCounter counter;
+  AllocationCounter allocations;
+
+  QBENCHMARK {
+    decodeInReads(decoder, buffer, data, readSize);
+    counter.add(data.size());
+    allocations.addFrames(frames);
+  }
+  QVERIFY(samples > 0);
+}
+
+void DecoderBench::sessionDecoding_data() {
+  QTest::addColumn<QByteArray>("data");
+  QTest::addColumn<qsizetype>("frames");
+  QTest::addColumn<qsizetype>("chunkSize");
+
+  const QByteArray synthetic = Corpus::syntheticSession(50);
+  QTest::newRow("synthetic") << synthetic << Corpus::countFrames(synthetic) << readSize;
+  QTest::newRow("synthetic, byte by byte") << synthetic << Corpus::countFrames(synthetic) << qsizetype(1);
+  const QByteArray recorded = Corpus::recordedSession();
+  if (!recorded.isEmpty())
+    QTest::newRow("recorded") << recorded << Corpus::countFrames(recorded) << readSize;
+}
+
+void DecoderBench::sessionDecoding() {
+  QFETCH(QByteArray, data);
+  QFETCH(qsizetype, frames);
+  QFETCH(qsizetype, chunkSize);
+  SessionDecoder decoder;
+  qsizetype tests = 0;
+  QObject::connect(&decoder, &SessionDecoder::waveformDecoded, [&tests]() { tests++; });
+  ThroughputCounter counter;
+  AllocationCounter allocations;
+
+  QBENCHMARK {
+    const uchar* src = reinterpret_cast<const uchar*>(data.constData());
+    for (qsizetype pos = 0; pos < data.size(); pos += chunkSize)
+      decoder.feed(src + pos, qMin(chunkSize, data.size() - pos));
+    counter.add(data.size());
+    allocations.addFrames(frames);
+  }
+  QVERIFY(tests > 0);
+}
+
+void DecoderBench::battInfoParsing() {
+  const QVector<QByteArray> texts = Corpus::battInfoTexts(64);
+  qsizetype textBytes = 0;
+  for (const QByteArray& text : texts)
+    textBytes += text.size();
+  BattInfo info;
+  ThroughputCounter counter;
+  AllocationCounter allocations;
+
+  QBENCHMARK {
+    for (const QByteArray& text : texts)
+      BattInfo::parse(text, info);
+    counter.add(textBytes);
+    allocations.addFrames(texts.size());
+  }
+  QVERIFY(info.soh > 0);
+}
@@ -0,0 +1,24 @@
+#ifndef DECODERBENCH_H
+#define DECODERBENCH_H
+
+#include <QObject>
+
+// Decoding of the received data, fed in the same small reads as it comes from the serial port.
+// Besides the time, the benchmarks report the throughput and the heap allocations per decoded frame.
+class DecoderBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void headerDetection_data();
+  void headerDetection();
+  void chartDecoding_data();
+  void chartDecoding();
+  void sessionDecoding_data();
+  void sessionDecoding();
+  void battInfoParsing();
+
+private:
+  static constexpr qsizetype readSize = 64; // typical amount of data available on a single readyRead at 115200 baud
+};
+
+#endif // DECODERBENCH_H
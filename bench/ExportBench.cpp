@@ -0,0 +1,56 @@
+#include "ExportBench.h"
+
+#include <QBuffer>
+#include <QTest>
+
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "Export.h"
+#include "WaveformRenderer.h"
+
+void ExportBench::addWaveformLengths() {
+  QTest::addColumn<qsizetype>("samples");
+  QTest::newRow("cranking test") << qsizetype(800);
+  QTest::newRow("long recording") << qsizetype(80000);
+}
+
+void ExportBench::waveformCsv_data() { addWaveformLengths(); }
+
+void ExportBench::waveformCsv() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  QByteArray output;
+  ThroughputCounter counter;
+  AllocationCounter allocations;
+
+  QBENCHMARK {
+    output.clear();
+    QBuffer buffer(&output);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+    Export::writeWaveformCsv(buffer, waveform);
+    counter.add(output.size());
+    allocations.addFrames(1);
+  }
+}
+
+void ExportBench::waveformPng_data() { addWaveformLengths(); }
+
+// Rendering of the whole chart and PNG encoding, the same work as the image export of the application.
+void ExportBench::waveformPng() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  const WaveformRenderer renderer;
+  QByteArray output;
+  ThroughputCounter counter;
+  AllocationCounter allocations;
+
+  QBENCHMARK {
+    const QImage image = renderer.renderImage(waveform, QSize(1600, 900), 144.0);
+    output.clear();
+    QBuffer buffer(&output);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+    counter.add(output.size());
+    allocations.addFrames(1);
+  }
+}
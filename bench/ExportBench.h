@@ -0,0 +1,20 @@
+#ifndef EXPORTBENCH_H
+#define EXPORTBENCH_H
+
+#include <QObject>
+
+// Saving of a waveform in the formats offered by the application, written to memory so the disk doesn't affect the results.
+class ExportBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void waveformCsv_data();
+  void waveformCsv();
+  void waveformPng_data();
+  void waveformPng();
+
+private:
+  void addWaveformLengths();
+};
+
+#endif // EXPORTBENCH_H
@@ -0,0 +1,125 @@
+#include "Fcs16Bench.h"
+
+#include <QTest>
+
+#include "BenchUtils.h"
+#include "Fcs16.h"
+
+namespace {
+// checksum calculation as it was done in MainWindow, with the table generated at runtime
+ushort legacyFcs16Lookup[256];
+
+void generateLegacyLookupTable() {
+  const ushort P = 0x8408;
+
+  for (ushort b = 0; b < 256; b++) {
+    ushort v = b;
+    for (uchar i = 8; i > 0; i--)
+      v = (v & 1) ? (v >> 1) ^ P : v >> 1;
+    legacyFcs16Lookup[b] = v & 0xFFFF;
+  }
+}
+
+QPair<ushort, ushort> legacyPacketChecksums(const uchar* packetToCheck, uint packetLen) {
+  ushort currentFcs = 0xFFFF;
+  uint checksumKonnwei = 0;
+
+  for (uint i = 0; i < packetLen; i++) {
+    ushort lastFcs = currentFcs;
+    currentFcs = (currentFcs >> 8) ^ legacyFcs16Lookup[(currentFcs ^ packetToCheck[i]) & 0xFF];
+    if (i < packetLen - 2)
+      checksumKonnwei = (lastFcs ^ packetToCheck[i]) << 16 | currentFcs;
+  }
+  return QPair<ushort, ushort>{currentFcs, (checksumKonnwei ^ 0xFFFF) & 0xFFFF};
+}
+} // namespace
+
+void Fcs16Bench::initTestCase() {
+  generateLegacyLookupTable();
+  packet.resize(65535);
+  for (qsizetype i = 0; i < packet.size(); i++)
+    packet[i] = static_cast<char>(i * 131 + 7);
+
+  // all kernels must give the same results as the old code
+  const uchar* data = reinterpret_cast<const uchar*>(packet.constData());
+  for (qsizetype len : {8, 10, 31, 32, 127, 128, 1000, 65533}) {
+    const QPair<ushort, ushort> legacy = legacyPacketChecksums(data, len);
+    const Fcs16::PacketChecksums checksums = Fcs16::calculatePacketChecksums(RingBuffer::View{{data, len}, {}}, len);
+    QCOMPARE(checksums.fcs, legacy.first);
+    QCOMPARE(checksums.konnwei, legacy.second);
+    QCOMPARE(Fcs16::updateSlicingBy8(Fcs16::initialFcs, data, len), Fcs16::updateBytewise(Fcs16::initialFcs, data, len));
+    if (Fcs16::clmulSupported())
+      QCOMPARE(Fcs16::updateClmul(Fcs16::initialFcs, data, len), Fcs16::updateBytewise(Fcs16::initialFcs, data, len));
+  }
+}
+
+void Fcs16Bench::addPacketSizes() {
+  QTest::addColumn<qsizetype>("size");
+  QTest::newRow("chart display") << qsizetype(8);
+  QTest::newRow("short chart") << qsizetype(256);
+  QTest::newRow("typical chart") << qsizetype(4096);
+  QTest::newRow("longest chart") << qsizetype(65533);
+}
+
+void Fcs16Bench::legacyBytewise_data() { addPacketSizes(); }
+
+void Fcs16Bench::legacyBytewise() {
+  QFETCH(qsizetype, size);
+  const uchar* data = reinterpret_cast<const uchar*>(packet.constData());
+  ThroughputCounter counter;
+  volatile ushort res = 0;
+
+  QBENCHMARK {
+    res = legacyPacketChecksums(data, size).first;
+    counter.add(size);
+  }
+  Q_UNUSED(res);
+}
+
+void Fcs16Bench::slicingBy8_data() { addPacketSizes(); }
+
+void Fcs16Bench::slicingBy8() {
+  QFETCH(qsizetype, size);
+  const uchar* data = reinterpret_cast<const uchar*>(packet.constData());
+  ThroughputCounter counter;
+  volatile ushort res = 0;
+
+  QBENCHMARK {
+    res = Fcs16::updateSlicingBy8(Fcs16::initialFcs, data, size);
+    counter.add(size);
+  }
+  Q_UNUSED(res);
+}
+
+void Fcs16Bench::clmul_data() { addPacketSizes(); }
+
+void Fcs16Bench::clmul() {
+  if (!Fcs16::clmulSupported())
+    QSKIP("PCLMULQDQ is not supported by this CPU");
+
+  QFETCH(qsizetype, size);
+  const uchar* data = reinterpret_cast<const uchar*>(packet.constData());
+  ThroughputCounter counter;
+  volatile ushort res = 0;
+
+  QBENCHMARK {
+    res = Fcs16::updateClmul(Fcs16::initialFcs, data, size);
+    counter.add(size);
+  }
+  Q_UNUSED(res);
+}
+
+void Fcs16Bench::packetChecksums_data() { addPacketSizes(); }
+
+void Fcs16Bench::packetChecksums() {
+  QFETCH(qsizetype, size);
+  const RingBuffer::View view{{reinterpret_cast<const uchar*>(packet.constData()), size}, {}};
+  ThroughputCounter counter;
+  volatile ushort res = 0;
+
+  QBENCHMARK {
+    res = Fcs16::calculatePacketChecksums(view, size).konnwei;
+    counter.add(size);
+  }
+  Q_UNUSED(res);
+}
@@ -0,0 +1,28 @@
+#ifndef FCS16BENCH_H
+#define FCS16BENCH_H
+
+#include <QObject>
+
+// Throughput of the checksum kernels against the byte-wise loop that MainWindow used before, for typical packet lengths.
+class Fcs16Bench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void legacyBytewise_data();
+  void legacyBytewise();
+  void slicingBy8_data();
+  void slicingBy8();
+  void clmul_data();
+  void clmul();
+  void packetChecksums_data();
+  void packetChecksums();
+
+private:
+  void addPacketSizes();
+
+private:
+  QByteArray packet;
+};
+
+#endif // FCS16BENCH_H
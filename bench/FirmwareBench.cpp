@@ -0,0 +1,156 @@
+#include "FirmwareBench.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QRandomGenerator>
+#include <QTest>
+#include <QTimer>
+
+#include "BenchUtils.h"
+#include "FirmwareUpdater.h"
+#include "emulator/FirmwareBootloader.h"
+
+namespace {
+constexpr qsizetype imageSize = 64 * 1024 + 123; // the last block is shorter
+constexpr qint64 lineRate = 11520;               // bytes per second, 115200 baud
+constexpr qint64 fastLineRate = 1000000;         // for the checks of the recovery, so they don't take long
+constexpr qint64 latencyNs = 2000000;            // each way, e.g. the latency timer of a USB serial adapter
+
+// Updater and bootloader connected by a serial line, which sends the bytes of each direction one after another at its rate,
+// delivers them after a fixed latency and can lose packets. Packets go through the frame decoder on each side, like the data of a real serial port.
+class Link : public QObject {
+public:
+  Link(FirmwareBootloader& bootloader, const FirmwareUpdater::Config& config, double lossRate, quint32 seed)
+      : bootloader(bootloader), bytesPerSecond(config.bytesPerSecond), lossRate(lossRate), rng(seed),
+        updater([this](const QByteArray& packet) { return send(packet, device); }, config) {
+    clock.start();
+    connect(&device.decoder, &FrameDecoder::firmwareFrameReceived, this, [this](uchar type, const RingBuffer::View& payload) {
+      const QByteArray answer = this->bootloader.handlePacket(type, payload);
+      if (!answer.isEmpty())
+        send(answer, host);
+    });
+    connect(&host.decoder, &FrameDecoder::firmwareFrameReceived, &updater, &FirmwareUpdater::handlePacket);
+  }
+
+  FirmwareUpdater& firmwareUpdater() { return updater; }
+
+  bool run(const QString& imageFileName) { // returns when the update finishes
+    QEventLoop loop;
+    bool success = false;
+    connect(&updater, &FirmwareUpdater::finished, &loop, [&](bool result, const QString& errorString) {
+      if (!errorString.isEmpty())
+        qWarning("%s", qPrintable(errorString));
+      success = result;
+      loop.quit();
+    });
+    updater.start(imageFileName);
+    if (updater.isRunning())
+      loop.exec();
+    return success;
+  }
+
+private:
+  struct Side {
+    RingBuffer received{128 * 1024};
+    FrameDecoder decoder;
+    qint64 lineFreeNs = 0; // when the line towards this side finishes sending the data written so far
+  };
+
+  bool send(const QByteArray& packet, Side& side) {
+    const qint64 now = clock.nsecsElapsed();
+    side.lineFreeNs = qMax(side.lineFreeNs, now) + packet.size() * 1000000000LL / bytesPerSecond; // a lost packet takes its time on the line too
+    if (lossRate > 0.0 && rng.generateDouble() < lossRate)
+      return true; // lost on the way, the sender doesn't know
+    const int delayMs = static_cast<int>((side.lineFreeNs + latencyNs - now + 999999) / 1000000);
+    QTimer::singleShot(delayMs, Qt::PreciseTimer, this, [packet, &side]() {
+      side.received.write(reinterpret_cast<const uchar*>(packet.constData()), packet.size());
+      side.received.consume(side.decoder.decode(side.received.view()));
+    });
+    return true;
+  }
+
+private:
+  FirmwareBootloader& bootloader;
+  qint64 bytesPerSecond;
+  double lossRate;
+  QRandomGenerator rng;
+  Side host, device;
+  QElapsedTimer clock;
+  FirmwareUpdater updater;
+};
+
+FirmwareUpdater::Config config(int window, quint16 blockSize, qint64 bytesPerSecond) {
+  FirmwareUpdater::Config res;
+  res.window = window;
+  res.blockSize = blockSize;
+  res.bytesPerSecond = bytesPerSecond; // the updater knows the rate of the line, like the real one knows the baud rate
+  res.timeoutMs = 200;                 // the round trip after a block left the line is a few ms, so only lost packets are sent again
+  res.maxRetries = 20;
+  return res;
+}
+} // namespace
+
+void FirmwareBench::initTestCase() {
+  QRandomGenerator rng(1);
+  imageData.resize(imageSize);
+  for (qsizetype i = 0; i < imageSize; i++)
+    imageData[i] = static_cast<char>(rng.bounded(256));
+  QVERIFY(image.open());
+  QCOMPARE(image.write(imageData), qint64(imageSize));
+  QVERIFY(image.flush());
+
+  // every lost block, acknowledgement and request is recovered from
+  FirmwareBootloader lossyBootloader(imageSize);
+  Link lossyLink(lossyBootloader, config(8, 1024, fastLineRate), 0.05, 2);
+  QVERIFY(lossyLink.run(image.fileName()));
+  QVERIFY(lossyLink.firmwareUpdater().retransmittedBlocks() > 0);
+  QCOMPARE(lossyBootloader.flash(), imageData);
+
+  // an update cancelled halfway continues where it stopped
+  FirmwareBootloader bootloader(imageSize);
+  Link link(bootloader, config(8, 1024, fastLineRate), 0.0, 3);
+  const QMetaObject::Connection halfway = connect(&link.firmwareUpdater(), &FirmwareUpdater::progressChanged, this, [&link](qint64 doneBytes, qint64 totalBytes) {
+    if (doneBytes >= totalBytes / 2)
+      link.firmwareUpdater().cancel();
+  });
+  QVERIFY(!link.run(image.fileName()));
+  disconnect(halfway);
+  QVERIFY(!bootloader.isImageComplete());
+  QVERIFY(link.run(image.fileName()));
+  QVERIFY(link.firmwareUpdater().resumedBlocks() >= imageSize / 2 / 1024);
+  QCOMPARE(bootloader.flash(), imageData);
+
+  // a window of seconds of data at 115200 baud waits in the port, none of it may time out while it's being sent
+  FirmwareBootloader slowBootloader(imageSize);
+  Link slowLink(slowBootloader, config(32, 4096, lineRate), 0.0, 4);
+  QVERIFY(slowLink.run(image.fileName()));
+  QCOMPARE(slowLink.firmwareUpdater().retransmittedBlocks(), quint64(0));
+  QCOMPARE(slowBootloader.flash(), imageData);
+}
+
+void FirmwareBench::update_data() {
+  QTest::addColumn<int>("window");
+  QTest::addColumn<int>("blockSize");
+  QTest::newRow("stop-and-wait, 256 B blocks") << 1 << 256;
+  QTest::newRow("stop-and-wait, 1 KiB blocks") << 1 << 1024;
+  QTest::newRow("window 2, 1 KiB blocks") << 2 << 1024;
+  QTest::newRow("window 8, 256 B blocks") << 8 << 256;
+  QTest::newRow("window 8, 1 KiB blocks") << 8 << 1024;
+  QTest::newRow("window 8, 4 KiB blocks") << 8 << 4096;
+}
+
+// Whole image at 115200 baud from the start each time, the bootloader is new so nothing is resumed. The line carries about 11.5 KB/s,
+// throughput close to it means the window hides the round trips and the per-packet overhead is small.
+void FirmwareBench::update() {
+  QFETCH(int, window);
+  QFETCH(int, blockSize);
+  ThroughputCounter counter;
+
+  QBENCHMARK {
+    FirmwareBootloader bootloader(imageSize);
+    Link link(bootloader, config(window, static_cast<quint16>(blockSize), lineRate), 0.0, 1);
+    QVERIFY(link.run(image.fileName()));
+    QCOMPARE(link.firmwareUpdater().retransmittedBlocks(), quint64(0));
+    counter.add(imageSize);
+  }
+}
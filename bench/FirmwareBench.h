@@ -0,0 +1,22 @@
+#ifndef FIRMWAREBENCH_H
+#define FIRMWAREBENCH_H
+
+#include <QObject>
+#include <QTemporaryFile>
+
+// Firmware update against the emulated bootloader, over a 115200 baud line with a fixed latency. The window keeps the line busy
+// while the acknowledgements are on their way, stop-and-wait shows what it costs without one.
+class FirmwareBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void update_data();
+  void update();
+
+private:
+  QTemporaryFile image;
+  QByteArray imageData;
+};
+
+#endif // FIRMWAREBENCH_H
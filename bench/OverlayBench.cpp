@@ -0,0 +1,89 @@
+#include "OverlayBench.h"
+
+#include <QTest>
+
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "WaveformOverlay.h"
+#include "WaveformRenderer.h"
+
+namespace {
+const WaveformOverlay::Parameters parameters;
+
+qsizetype delayOf(qsizetype test) { return test * 7 % 40; }
+
+// the same test recorded with a different delay before cranking
+Waveform delayedWaveform(const Waveform& waveform, qsizetype delay) {
+  Waveform res(waveform.timebase());
+  for (qsizetype i = 0; i < delay; i++)
+    res.append(waveform.constData(), 1);
+  res.append(waveform.samples());
+  return res;
+}
+
+WaveformOverlay buildOverlay(const Waveform& waveform, qsizetype tests) {
+  WaveformOverlay overlay;
+  for (qsizetype i = 0; i < tests; i++)
+    overlay.add(i, QStringLiteral("bench"), delayedWaveform(waveform, delayOf(i)), parameters);
+  overlay.computeBand(parameters);
+  return overlay;
+}
+} // namespace
+
+void OverlayBench::initTestCase() {
+  // tests that differ only in the delay before cranking must be aligned exactly, so the band collapses to the test itself
+  const Waveform waveform = Corpus::crankingWaveform(800);
+  const WaveformOverlay overlay = buildOverlay(waveform, 8);
+  QVERIFY(overlay.hasBand());
+  const qsizetype start = WaveformOverlay::crankingStart(waveform, parameters);
+  for (qsizetype i = 0; i < overlay.size(); i++)
+    QCOMPARE(WaveformOverlay::crankingStart(overlay.members()[i].series.waveform, parameters), start + delayOf(i));
+
+  const WaveformOverlay::Band& band = overlay.band();
+  const qsizetype shift = qRound(band.mean.offset / waveform.timebase().timeAt(1)) - start; // first band point in the samples of the original
+  for (qsizetype i = 0; i < band.mean.waveform.size(); i++) {
+    QCOMPARE(band.low.waveform.sample(i), waveform.sample(shift + i));
+    QCOMPARE(band.mean.waveform.sample(i), waveform.sample(shift + i));
+    QCOMPARE(band.high.waveform.sample(i), waveform.sample(shift + i));
+  }
+}
+
+void OverlayBench::addOverlaySizes() {
+  QTest::addColumn<qsizetype>("samples");
+  QTest::addColumn<qsizetype>("tests");
+  QTest::newRow("50 cranking tests") << qsizetype(800) << qsizetype(50);
+  QTest::newRow("200 cranking tests") << qsizetype(800) << qsizetype(200);
+  QTest::newRow("50 long recordings") << qsizetype(80000) << qsizetype(50);
+}
+
+void OverlayBench::build_data() { addOverlaySizes(); }
+
+void OverlayBench::build() {
+  QFETCH(qsizetype, samples);
+  QFETCH(qsizetype, tests);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  ThroughputCounter counter;
+
+  QBENCHMARK {
+    const WaveformOverlay overlay = buildOverlay(waveform, tests);
+    counter.add(samples * tests * 2);
+  }
+}
+
+void OverlayBench::repaint_data() { addOverlaySizes(); }
+
+// the whole overlay in a full HD window, as after loading it
+void OverlayBench::repaint() {
+  QFETCH(qsizetype, samples);
+  QFETCH(qsizetype, tests);
+  const WaveformOverlay overlay = buildOverlay(Corpus::crankingWaveform(samples), tests);
+  const WaveformRenderer::Viewport viewport = WaveformRenderer::fullViewport(overlay);
+
+  QImage image(1920, 1080, QImage::Format_RGB32);
+  QPainter painter(&image);
+  painter.setRenderHint(QPainter::Antialiasing);
+  const WaveformRenderer renderer;
+  QBENCHMARK {
+    renderer.render(painter, QRectF(image.rect()), overlay, viewport);
+  }
+}
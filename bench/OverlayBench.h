@@ -0,0 +1,21 @@
+#ifndef OVERLAYBENCH_H
+#define OVERLAYBENCH_H
+
+#include <QObject>
+
+// Comparison of many tests from the history, building the overlay runs in the background, repaints must stay interactive.
+class OverlayBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void build_data();
+  void build();
+  void repaint_data();
+  void repaint();
+
+private:
+  void addOverlaySizes();
+};
+
+#endif // OVERLAYBENCH_H
@@ -0,0 +1,54 @@
+#include "RingBufferBench.h"
+
+#include <QTest>
+
+#include "RingBuffer.h"
+
+void RingBufferBench::initTestCase() {
+  stream.resize(256 * packetSize);
+  for (qsizetype i = 0; i < stream.size(); i++)
+    stream[i] = static_cast<char>(i * 31);
+}
+
+void RingBufferBench::legacyAccumulatingBuffer() {
+  quint64 copiedBytes = 0;
+
+  QBENCHMARK {
+    copiedBytes = 0;
+    QByteArray spData;
+    QVector<uchar> receivedPacket;
+    for (qsizetype pos = 0; pos < stream.size(); pos += readSize) {
+      spData.append(stream.constData() + pos, readSize); // SerialPort::spDataReceived()
+      copiedBytes += readSize;
+
+      receivedPacket.clear(); // MainWindow::onSerialPortDataReceived() got the whole spData again
+      for (char b : std::as_const(spData))
+        receivedPacket.append(static_cast<uchar>(b));
+      copiedBytes += spData.size();
+
+      if (receivedPacket.size() >= packetSize) { // packet processed, remove it from the front of both buffers
+        receivedPacket.erase(receivedPacket.cbegin(), receivedPacket.cbegin() + packetSize);
+        spData.erase(spData.cbegin(), spData.cbegin() + packetSize);
+        copiedBytes += receivedPacket.size() + spData.size();
+      }
+    }
+  }
+  qInfo("bytes copied per received byte: %.2f", static_cast<double>(copiedBytes) / stream.size());
+}
+
+void RingBufferBench::ringBuffer() {
+  quint64 copiedBytes = 0;
+
+  QBENCHMARK {
+    RingBuffer spData(128 * 1024);
+    for (qsizetype pos = 0; pos < stream.size(); pos += readSize) {
+      spData.write(reinterpret_cast<const uchar*>(stream.constData()) + pos, readSize);
+
+      const RingBuffer::View receivedPacket = spData.view();
+      if (receivedPacket.length() >= packetSize)
+        spData.consume(packetSize);
+    }
+    copiedBytes = spData.totalWritten();
+  }
+  qInfo("bytes copied per received byte: %.2f", static_cast<double>(copiedBytes) / stream.size());
+}
@@ -0,0 +1,22 @@
+#ifndef RINGBUFFERBENCH_H
+#define RINGBUFFERBENCH_H
+
+#include <QObject>
+
+// Compares the old receive path (whole buffer re-emitted and copied byte by byte on every read) with the ring buffer.
+// Besides the time, both benchmarks report how many times each received byte was copied.
+class RingBufferBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void legacyAccumulatingBuffer();
+  void ringBuffer();
+
+private:
+  static constexpr qsizetype readSize = 64;     // typical amount of data available on a single readyRead at 115200 baud
+  static constexpr qsizetype packetSize = 1024; // length of a single chart packet in the stream
+  QByteArray stream;                            // a few seconds of chart packets
+};
+
+#endif // RINGBUFFERBENCH_H
@@ -0,0 +1,114 @@
+#include "WaveformCodecBench.h"
+
+#include <QTest>
+#include <QtEndian>
+
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "WaveformCodec.h"
+
+namespace {
+QByteArray encoded(const Waveform& waveform) {
+  QByteArray res(WaveformCodec::maxEncodedSize(waveform.size()), Qt::Uninitialized);
+  res.truncate(WaveformCodec::encode(waveform.constData(), waveform.size(), reinterpret_cast<uchar*>(res.data())));
+  return res;
+}
+} // namespace
+
+void WaveformCodecBench::initTestCase() {
+  // both decoders must give back exactly the encoded samples, also for noise and the longest differences
+  Waveform noise;
+  for (qsizetype i = 0; i < 1000; i++) {
+    const ushort sample = static_cast<ushort>(i * 40503u ^ (i << 3));
+    noise.append(&sample, 1);
+  }
+
+  for (const Waveform& waveform : {Corpus::crankingWaveform(800), Corpus::crankingWaveform(1001), noise}) {
+    const QByteArray data = encoded(waveform);
+    const uchar* bytes = reinterpret_cast<const uchar*>(data.constData());
+    QVector<ushort> decoded(waveform.size());
+    QCOMPARE(WaveformCodec::decodeScalar(bytes, data.size(), decoded.data(), decoded.size()), data.size());
+    QCOMPARE(decoded, waveform.samples());
+    if (WaveformCodec::simdSupported()) {
+      decoded.fill(0);
+      QCOMPARE(WaveformCodec::decodeSimd(bytes, data.size(), decoded.data(), decoded.size()), data.size());
+      QCOMPARE(decoded, waveform.samples());
+    }
+  }
+
+  const Waveform waveform = Corpus::crankingWaveform(80000);
+  qInfo("compression ratio of a cranking waveform: %.2f", static_cast<double>(waveform.size() * 2) / encoded(waveform).size());
+}
+
+void WaveformCodecBench::addWaveformLengths() {
+  QTest::addColumn<qsizetype>("samples");
+  QTest::newRow("cranking test") << qsizetype(800);
+  QTest::newRow("long recording") << qsizetype(80000);
+}
+
+void WaveformCodecBench::encode_data() { addWaveformLengths(); }
+
+void WaveformCodecBench::encode() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  QByteArray output(WaveformCodec::maxEncodedSize(samples), Qt::Uninitialized);
+  ThroughputCounter counter;
+  volatile qsizetype res = 0;
+
+  QBENCHMARK {
+    res = WaveformCodec::encode(waveform.constData(), samples, reinterpret_cast<uchar*>(output.data()));
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
+
+void WaveformCodecBench::rawSamples_data() { addWaveformLengths(); }
+
+void WaveformCodecBench::rawSamples() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  QByteArray raw(samples * 2, Qt::Uninitialized);
+  qToLittleEndian<quint16>(waveform.constData(), samples, raw.data());
+  QVector<ushort> output(samples);
+  ThroughputCounter counter;
+
+  QBENCHMARK {
+    qFromLittleEndian<quint16>(raw.constData(), samples, output.data());
+    counter.add(samples * 2);
+  }
+}
+
+void WaveformCodecBench::decodeScalar_data() { addWaveformLengths(); }
+
+void WaveformCodecBench::decodeScalar() {
+  QFETCH(qsizetype, samples);
+  const QByteArray data = encoded(Corpus::crankingWaveform(samples));
+  QVector<ushort> output(samples);
+  ThroughputCounter counter;
+  volatile qsizetype res = 0;
+
+  QBENCHMARK {
+    res = WaveformCodec::decodeScalar(reinterpret_cast<const uchar*>(data.constData()), data.size(), output.data(), samples);
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
+
+void WaveformCodecBench::decodeSimd_data() { addWaveformLengths(); }
+
+void WaveformCodecBench::decodeSimd() {
+  if (!WaveformCodec::simdSupported())
+    QSKIP("SIMD decoder is not available on this CPU");
+
+  QFETCH(qsizetype, samples);
+  const QByteArray data = encoded(Corpus::crankingWaveform(samples));
+  QVector<ushort> output(samples);
+  ThroughputCounter counter;
+  volatile qsizetype res = 0;
+
+  QBENCHMARK {
+    res = WaveformCodec::decodeSimd(reinterpret_cast<const uchar*>(data.constData()), data.size(), output.data(), samples);
+    counter.add(samples * 2);
+  }
+  Q_UNUSED(res);
+}
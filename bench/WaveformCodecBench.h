@@ -0,0 +1,26 @@
+#ifndef WAVEFORMCODECBENCH_H
+#define WAVEFORMCODECBENCH_H
+
+#include <QObject>
+
+// Compression of waveforms, throughput is given in bytes of raw samples. Decoders are compared with reading the raw little-endian samples,
+// which is what the history store had to do before.
+class WaveformCodecBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void encode_data();
+  void encode();
+  void rawSamples_data();
+  void rawSamples();
+  void decodeScalar_data();
+  void decodeScalar();
+  void decodeSimd_data();
+  void decodeSimd();
+
+private:
+  void addWaveformLengths();
+};
+
+#endif // WAVEFORMCODECBENCH_H
@@ -0,0 +1,95 @@
+#include "WaveformPyramidBench.h"
+
+#include <QTest>
+
+#include "BenchUtils.h"
+#include "Corpus.h"
+#include "WaveformPyramid.h"
+#include "WaveformRenderer.h"
+
+void WaveformPyramidBench::initTestCase() {
+  // ranges must be exact for any alignment, also while the waveform is still growing
+  const Waveform full = Corpus::crankingWaveform(5000);
+  Waveform growing;
+  WaveformPyramid pyramid;
+  for (qsizetype size = 0; size < full.size(); size += 337) {
+    growing.append(full.constData() + size, qMin(qsizetype(337), full.size() - size));
+    pyramid.update(growing);
+    for (qsizetype first = 0; first < growing.size(); first += 97) {
+      for (const qsizetype length : {qsizetype(1), qsizetype(5), qsizetype(64), qsizetype(1000), growing.size()}) {
+        const qsizetype last = qMin(first + length, growing.size());
+        ushort low = growing.sample(first), high = growing.sample(first);
+        for (qsizetype i = first; i < last; i++) {
+          low = qMin(low, growing.sample(i));
+          high = qMax(high, growing.sample(i));
+        }
+        const WaveformPyramid::Range r = pyramid.range(growing, first, last);
+        QCOMPARE(r.low, low);
+        QCOMPARE(r.high, high);
+      }
+    }
+  }
+
+  // an update that adds a level must fill its blocks over the samples processed by the previous updates as well
+  for (const qsizetype size : {qsizetype(16), qsizetype(64)}) {
+    QVector<ushort> samples(size + 1, 500);
+    samples[0] = 100;
+    Waveform waveform;
+    WaveformPyramid grown;
+    waveform.append(samples.constData(), size);
+    grown.update(waveform);
+    waveform.append(samples.constData() + size, 1);
+    grown.update(waveform);
+    const WaveformPyramid::Range r = grown.range(waveform, 0, size + 1);
+    QCOMPARE(r.low, ushort(100));
+    QCOMPARE(r.high, ushort(500));
+  }
+}
+
+void WaveformPyramidBench::addWaveformLengths() {
+  QTest::addColumn<qsizetype>("samples");
+  QTest::newRow("cranking test") << qsizetype(800);
+  QTest::newRow("long recording") << qsizetype(80000);
+  QTest::newRow("hour recording") << qsizetype(288000);
+}
+
+void WaveformPyramidBench::build_data() { addWaveformLengths(); }
+
+void WaveformPyramidBench::build() {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  WaveformPyramid pyramid;
+  ThroughputCounter counter;
+
+  QBENCHMARK {
+    pyramid.clear();
+    pyramid.update(waveform);
+    counter.add(samples * 2);
+  }
+}
+
+// the middle tenth of the waveform in a full HD window
+void WaveformPyramidBench::repaint(bool withPyramid) {
+  QFETCH(qsizetype, samples);
+  const Waveform waveform = Corpus::crankingWaveform(samples);
+  WaveformPyramid pyramid;
+  pyramid.update(waveform);
+  WaveformRenderer::Viewport viewport = WaveformRenderer::fullViewport(waveform);
+  viewport.minTime = waveform.duration() * 0.45;
+  viewport.maxTime = waveform.duration() * 0.55;
+
+  QImage image(1920, 1080, QImage::Format_RGB32);
+  QPainter painter(&image);
+  const WaveformRenderer renderer;
+  QBENCHMARK {
+    renderer.render(painter, QRectF(image.rect()), waveform, viewport, withPyramid ? &pyramid : nullptr);
+  }
+}
+
+void WaveformPyramidBench::repaintScan_data() { addWaveformLengths(); }
+
+void WaveformPyramidBench::repaintScan() { repaint(false); }
+
+void WaveformPyramidBench::repaintPyramid_data() { addWaveformLengths(); }
+
+void WaveformPyramidBench::repaintPyramid() { repaint(true); }
@@ -0,0 +1,24 @@
+#ifndef WAVEFORMPYRAMIDBENCH_H
+#define WAVEFORMPYRAMIDBENCH_H
+
+#include <QObject>
+
+// Drawing of the waveform view, a repaint must cost the same for any length of the waveform.
+class WaveformPyramidBench : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void build_data();
+  void build();
+  void repaintScan_data();
+  void repaintScan();
+  void repaintPyramid_data();
+  void repaintPyramid();
+
+private:
+  void addWaveformLengths();
+  void repaint(bool withPyramid);
+};
+
+#endif // WAVEFORMPYRAMIDBENCH_H
@@ -0,0 +1,39 @@
+#include <QGuiApplication>
+#include <QTest>
+
+#include "AnalysisBench.h"
+#include "DecoderBench.h"
+#include "ExportBench.h"
+#include "Fcs16Bench.h"
+#include "FirmwareBench.h"
+#include "OverlayBench.h"
+#include "RingBufferBench.h"
+#include "WaveformCodecBench.h"
+#include "WaveformPyramidBench.h"
+
+int main(int argc, char* argv[]) {
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen"); // image export benchmarks don't need a display
+  QGuiApplication a(argc, argv);
+
+  int status = 0;
+  RingBufferBench ringBufferBench;
+  status |= QTest::qExec(&ringBufferBench, argc, argv);
+  Fcs16Bench fcs16Bench;
+  status |= QTest::qExec(&fcs16Bench, argc, argv);
+  DecoderBench decoderBench;
+  status |= QTest::qExec(&decoderBench, argc, argv);
+  ExportBench exportBench;
+  status |= QTest::qExec(&exportBench, argc, argv);
+  WaveformCodecBench waveformCodecBench;
+  status |= QTest::qExec(&waveformCodecBench, argc, argv);
+  AnalysisBench analysisBench;
+  status |= QTest::qExec(&analysisBench, argc, argv);
+  WaveformPyramidBench waveformPyramidBench;
+  status |= QTest::qExec(&waveformPyramidBench, argc, argv);
+  OverlayBench overlayBench;
+  status |= QTest::qExec(&overlayBench, argc, argv);
+  FirmwareBench firmwareBench;
+  status |= QTest::qExec(&firmwareBench, argc, argv);
+  return status;
+}
@@ -0,0 +1,202 @@
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+
+#include "CaptureFile.h"
+#include "Export.h"
+#include "ReportWriter.h"
+#include "SessionDecoder.h"
+#include "Trace.h"
+#include "WaveformRenderer.h"
+
+namespace {
+struct Options {
+  QString outputDir; // empty means next to the capture file
+  bool stateAsCsv = false;
+  QByteArray waveformFormat = "csv"; // csv or an image format
+  QSize imageSize{1600, 900};
+  qreal imageDpi = 144.0;
+  bool pdfPerCapture = false; // <capture>-report.pdf with all the tests of the capture
+};
+
+struct FileResult {
+  qsizetype states = 0;
+  qsizetype waveforms = 0;
+  quint64 checksumFailures = 0;
+  quint64 droppedBytes = 0;
+  QString error;
+};
+
+bool writeFile(const QString& fileName, const std::function<bool(QIODevice&)>& writer, QString& error) {
+  QFile file(fileName);
+  if (!file.open(QFile::WriteOnly | QFile::Text)) {
+    error = fileName + ": " + file.errorString();
+    return false;
+  }
+  if (!writer(file)) {
+    error = fileName + ": " + file.errorString();
+    return false;
+  }
+  return true;
+}
+
+// Runs in a thread of the pool, everything used here belongs to this call only, except the combined report,
+// which is passed only when the captures are decoded one after another.
+FileResult decodeCapture(const QString& fileName, const Options& opt, ReportWriter* combinedReport = nullptr) {
+  const Trace::Span span("decodeCapture");
+  FileResult res;
+  CaptureReader reader;
+  if (!reader.open(fileName)) {
+    res.error = fileName + ": " + reader.errorString();
+    return res;
+  }
+
+  const QFileInfo info(fileName);
+  const QString base = QDir(opt.outputDir.isEmpty() ? info.path() : opt.outputDir).filePath(info.completeBaseName());
+
+  std::unique_ptr<QPdfWriter> pdf;
+  std::unique_ptr<ReportWriter> captureReport;
+  if (opt.pdfPerCapture) {
+    pdf = std::make_unique<QPdfWriter>(base + "-report.pdf");
+    ReportWriter::Style style;
+    style.title = info.fileName();
+    ReportWriter::setupPdf(*pdf, style.title);
+    captureReport = std::make_unique<ReportWriter>(pdf.get(), style);
+  }
+  const auto reports = {captureReport.get(), combinedReport};
+
+  SessionDecoder decoder;
+  QObject::connect(&decoder, &SessionDecoder::battInfoDecoded, [&](const BattInfo& battInfo) {
+    for (ReportWriter* report : reports)
+      if (report)
+        report->addState(QString("%1: battery state %2").arg(info.fileName()).arg(res.states + 1), battInfo);
+    const QString outName = QString("%1-state-%2.%3").arg(base).arg(++res.states).arg(opt.stateAsCsv ? "csv" : "txt");
+    writeFile(outName, [&](QIODevice& device) {
+      QTextStream data(&device);
+      opt.stateAsCsv ? Export::writeStateCsv(data, battInfo) : Export::writeStateTxt(data, battInfo);
+      data.flush();
+      return data.status() == QTextStream::Ok;
+    }, res.error);
+  });
+  QObject::connect(&decoder, &SessionDecoder::waveformDecoded, [&](const Waveform& waveform) {
+    for (ReportWriter* report : reports)
+      if (report)
+        report->addWaveform(QString("%1: waveform %2").arg(info.fileName()).arg(res.waveforms + 1), waveform);
+    const QString outName = QString("%1-waveform-%2.%3").arg(base).arg(++res.waveforms).arg(QString::fromLatin1(opt.waveformFormat));
+    if (opt.waveformFormat == "csv")
+      writeFile(outName, [&](QIODevice& device) { return Export::writeWaveformCsv(device, waveform); }, res.error);
+    else if (!WaveformRenderer().renderImage(waveform, opt.imageSize, opt.imageDpi).save(outName, opt.waveformFormat.constData()))
+      res.error = outName + ": unable to save the image";
+  });
+
+  CaptureReader::Chunk chunk;
+  while (reader.readChunk(chunk))
+    decoder.feed(chunk.data, chunk.length);
+
+  if (captureReport && !captureReport->finish())
+    res.error = base + "-report.pdf: unable to write the report";
+  res.checksumFailures = decoder.checksumFailures();
+  res.droppedBytes = decoder.droppedBytes();
+  return res;
+}
+} // namespace
+
+int main(int argc, char* argv[]) {
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen"); // images are rendered without a display
+  QGuiApplication a(argc, argv);
+  QCoreApplication::setApplicationName("kbtinfo-cli");
+  QCoreApplication::setApplicationVersion("v1.0.0.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Decodes KBTinfo capture files and saves the battery state and waveforms of every test.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  const QCommandLineOption outputOption({"o", "output"}, "Directory for the decoded files, by default next to each capture file.", "dir");
+  const QCommandLineOption formatOption("state-format", "Format of the battery state files: txt or csv.", "format", "txt");
+  const QCommandLineOption waveformFormatOption("waveform-format", "Format of the waveform files: csv, png, jpg or bmp.", "format", "csv");
+  const QCommandLineOption imageSizeOption("image-size", "Size of the waveform images in pixels.", "WxH", "1600x900");
+  const QCommandLineOption dpiOption("dpi", "Resolution of the waveform images, scales the text and lines.", "dpi", "144");
+  const QCommandLineOption pdfOption("pdf", "Save a PDF report of each capture file.");
+  const QCommandLineOption reportOption("report", "Save a single PDF report of all the capture files, the files are decoded one after another then.", "file");
+  const QCommandLineOption jobsOption({"j", "jobs"}, "Number of files decoded at the same time, all cores by default.", "count");
+  const QCommandLineOption traceOption("trace", "Write a trace of the decoding in the Chrome trace event format.", "file");
+  parser.addOptions({outputOption, formatOption, waveformFormatOption, imageSizeOption, dpiOption, pdfOption, reportOption, jobsOption, traceOption});
+  parser.addPositionalArgument("captures", "Capture files to decode.", "<capture>...");
+  parser.process(a);
+
+  const QStringList files = parser.positionalArguments();
+  const QString stateFormat = parser.value(formatOption);
+  const QString waveformFormat = parser.value(waveformFormatOption);
+  const QStringList imageSize = parser.value(imageSizeOption).split('x');
+  const qreal dpi = parser.value(dpiOption).toDouble();
+  if (files.isEmpty() || (stateFormat != "txt" && stateFormat != "csv") || !QStringList{"csv", "png", "jpg", "bmp"}.contains(waveformFormat) || imageSize.size() != 2
+      || imageSize[0].toInt() <= 0 || imageSize[1].toInt() <= 0 || dpi <= 0.0)
+    parser.showHelp(1);
+
+  Options opt;
+  opt.outputDir = parser.value(outputOption);
+  opt.stateAsCsv = stateFormat == "csv";
+  opt.waveformFormat = waveformFormat.toLatin1();
+  opt.imageSize = QSize(imageSize[0].toInt(), imageSize[1].toInt());
+  opt.imageDpi = dpi;
+  opt.pdfPerCapture = parser.isSet(pdfOption);
+  if (!opt.outputDir.isEmpty() && !QDir().mkpath(opt.outputDir)) {
+    QTextStream(stderr) << "Unable to create the output directory " << opt.outputDir << Qt::endl;
+    return 1;
+  }
+
+  QThreadPool pool;
+  if (parser.isSet(jobsOption))
+    pool.setMaxThreadCount(qMax(parser.value(jobsOption).toInt(), 1));
+
+  QVector<FileResult> results(files.size()); // each task writes only its own element
+  int status = 0;
+  if (parser.isSet(traceOption))
+    Trace::start();
+  if (parser.isSet(reportOption)) { // pages must be in the order of the files, so there is a single task writing all of them
+    QPdfWriter pdf(parser.value(reportOption));
+    ReportWriter::setupPdf(pdf, ReportWriter::Style().title);
+    ReportWriter report(&pdf);
+    pool.start([&files, &opt, &results, &report]() {
+      for (qsizetype i = 0; i < files.size(); i++)
+        results[i] = decodeCapture(files[i], opt, &report);
+    });
+    pool.waitForDone();
+    if (!report.finish()) {
+      QTextStream(stderr) << parser.value(reportOption) << ": unable to write the report" << Qt::endl;
+      status = 1;
+    }
+  } else {
+    for (qsizetype i = 0; i < files.size(); i++)
+      pool.start([&files, &opt, &results, i]() { results[i] = decodeCapture(files[i], opt); });
+    pool.waitForDone();
+  }
+
+  if (parser.isSet(traceOption)) {
+    Trace::stop();
+    QFile traceFile(parser.value(traceOption));
+    if (!traceFile.open(QFile::WriteOnly) || !Trace::writeJson(traceFile)) {
+      QTextStream(stderr) << parser.value(traceOption) << ": unable to write the trace" << Qt::endl;
+      status = 1;
+    }
+  }
+
+  QTextStream out(stdout);
+  for (qsizetype i = 0; i < files.size(); i++) {
+    const FileResult& res = results[i];
+    out << files[i] << ": " << res.states << " battery states, " << res.waveforms << " waveforms, " << res.checksumFailures << " checksum errors, " << res.droppedBytes
+        << " bytes dropped" << Qt::endl;
+    if (!res.error.isEmpty()) {
+      QTextStream(stderr) << res.error << Qt::endl;
+      status = 1;
+    }
+  }
+  return status;
+}
@@ -0,0 +1,71 @@
+#include "FirmwareBootloader.h"
+
+#include <cstring>
+
+#include "Fcs16.h"
+
+FirmwareBootloader::FirmwareBootloader(qsizetype flashSize) : flashData(flashSize, static_cast<char>(0xFF)) {} // erased flash
+
+QByteArray FirmwareBootloader::handlePacket(uchar type, const RingBuffer::View& payload) {
+  if (type == uchar(FirmwareProtocol::Type::Start))
+    return onStart(payload);
+  if (type == uchar(FirmwareProtocol::Type::Block))
+    return onBlock(payload);
+  if (type == uchar(FirmwareProtocol::Type::Finish))
+    return onFinish(payload);
+  return QByteArray(); // answers of another device
+}
+
+QByteArray FirmwareBootloader::onStart(const RingBuffer::View& payload) {
+  FirmwareProtocol::Start start;
+  if (!FirmwareProtocol::parseStart(payload, start))
+    return QByteArray();
+  if (start.imageSize == 0 || start.imageSize > flashData.size() || start.blockSize == 0 || start.blockSize > FirmwareProtocol::maxBlockSize)
+    return FirmwareProtocol::done(FirmwareProtocol::Status::Failed);
+
+  if (start.imageSize != image.imageSize || start.blockSize != image.blockSize || start.imageFcs != image.imageFcs) { // another image, start over
+    image = start;
+    written.fill(false, (image.imageSize + image.blockSize - 1) / image.blockSize);
+  }
+  complete = false;
+  quint32 resume = 0;
+  while (resume < written.size() && written[resume])
+    resume++;
+  return FirmwareProtocol::ready(resume);
+}
+
+QByteArray FirmwareBootloader::onBlock(const RingBuffer::View& payload) {
+  quint32 index;
+  if (!FirmwareProtocol::parseBlockIndex(payload, index))
+    return QByteArray();
+  if (index >= written.size())
+    return FirmwareProtocol::done(FirmwareProtocol::Status::Failed); // no start or a block of another image
+
+  FirmwareProtocol::BlockAck ack;
+  ack.index = index;
+  const RingBuffer::View data = payload.mid(FirmwareProtocol::blockHeaderSize);
+  if (data.length() != blockLength(index)) {
+    ack.status = FirmwareProtocol::Status::Retry;
+    return FirmwareProtocol::blockAck(ack);
+  }
+
+  uchar* dest = reinterpret_cast<uchar*>(flashData.data()) + static_cast<qsizetype>(index) * image.blockSize;
+  memcpy(dest, data.first().data, data.first().length);
+  memcpy(dest + data.first().length, data.second().data, data.second().length);
+  written[index] = true;
+  blocksWritten++;
+  ack.fcs = Fcs16::update(Fcs16::initialFcs, dest, data.length()); // read back from the flash
+  return FirmwareProtocol::blockAck(ack);
+}
+
+QByteArray FirmwareBootloader::onFinish(const RingBuffer::View& payload) {
+  quint16 imageFcs;
+  if (!FirmwareProtocol::parseFinish(payload, imageFcs))
+    return QByteArray();
+
+  complete = !written.isEmpty() && !written.contains(false) && imageFcs == image.imageFcs
+             && Fcs16::update(Fcs16::initialFcs, reinterpret_cast<const uchar*>(flashData.constData()), image.imageSize) == image.imageFcs;
+  if (!complete)
+    written.fill(false); // the next attempt writes every block again
+  return FirmwareProtocol::done(complete ? FirmwareProtocol::Status::Ok : FirmwareProtocol::Status::Failed);
+}
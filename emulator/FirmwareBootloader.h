@@ -0,0 +1,39 @@
+#ifndef FIRMWAREBOOTLOADER_H
+#define FIRMWAREBOOTLOADER_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "FirmwareProtocol.h"
+#include "RingBuffer.h"
+
+// Device side of the firmware update, see FirmwareProtocol. Blocks are written into an emulated flash as they arrive, in any order.
+// Written blocks are remembered until another image is started, so an interrupted update of the same image continues
+// with the first block that is missing.
+class FirmwareBootloader {
+public:
+  explicit FirmwareBootloader(qsizetype flashSize);
+
+public:
+  // Answer to a firmware packet received from the host, empty when the packet doesn't need one.
+  QByteArray handlePacket(uchar type, const RingBuffer::View& payload);
+  const QByteArray& flash() const { return flashData; }
+  qsizetype imageSize() const { return image.imageSize; }
+  bool isImageComplete() const { return complete; } // the whole image was written and its FCS matched
+  quint64 writtenBlocks() const { return blocksWritten; } // including the ones written again
+
+private:
+  QByteArray onStart(const RingBuffer::View& payload);
+  QByteArray onBlock(const RingBuffer::View& payload);
+  QByteArray onFinish(const RingBuffer::View& payload);
+  qsizetype blockLength(qsizetype index) const { return qMin(static_cast<qsizetype>(image.blockSize), image.imageSize - index * image.blockSize); }
+
+private:
+  QByteArray flashData;
+  FirmwareProtocol::Start image; // the image being written, imageSize is 0 before the first start
+  QVector<bool> written;
+  bool complete = false;
+  quint64 blocksWritten = 0;
+};
+
+#endif // FIRMWAREBOOTLOADER_H
@@ -0,0 +1,76 @@
+#include "PacketBuilder.h"
+
+#include <QtEndian>
+
+#include "Fcs16.h"
+
+namespace PacketBuilder {
+namespace {
+QByteArray type2(uchar type, const uchar* data, qsizetype len) {
+  const ushort packetLen = static_cast<ushort>(len + 10);
+  QByteArray packet;
+  packet.reserve(packetLen);
+  packet.append("\x24\x24", 2);
+  packet.append(static_cast<char>(packetLen & 0xFF));
+  packet.append(static_cast<char>(packetLen >> 8));
+  packet.append(static_cast<char>(0xFF));
+  packet.append(static_cast<char>(type));
+  packet.append(reinterpret_cast<const char*>(data), len);
+
+  // Konnwei checksum is the complemented FCS sent lower byte first, so the FCS of the whole packet ends up at the correct value
+  const ushort checksum = Fcs16::update(Fcs16::initialFcs, reinterpret_cast<const uchar*>(packet.constData()), packet.size()) ^ 0xFFFF;
+  packet.append(static_cast<char>(checksum & 0xFF));
+  packet.append(static_cast<char>(checksum >> 8));
+  packet.append("\r\n", 2);
+  return packet;
+}
+} // namespace
+
+QByteArray battInfo(const QByteArray& text) {
+  QByteArray packet("\x00\x24\x24\xFF\xFE\xBD\x6F", 7);
+  packet.reserve(7 + text.size() + 2);
+  packet.append(text);
+  packet.append("\r\n", 2);
+  return packet;
+}
+
+QByteArray chart(const ushort* samples, qsizetype count) {
+  QByteArray data(count * 2, Qt::Uninitialized);
+  qToLittleEndian<ushort>(samples, count, data.data()); // lower byte is transmitted first
+  return type2(0x01, reinterpret_cast<const uchar*>(data.constData()), data.size());
+}
+
+QByteArray chartDisplay() { return type2(0x02, nullptr, 0); }
+
+QByteArray sampleBattInfoText(QRandomGenerator& rng) {
+  const int soh = rng.bounded(40, 101), soc = rng.bounded(30, 101);
+  const int rated = 600, measured = rated * soh / 100 + rng.bounded(-20, 21);
+  const double resistance = 3.0 + (100 - soh) * 0.05 + rng.bounded(0.5), voltage = 12.0 + soc * 0.008;
+
+  QByteArray text;
+  text += "SOH = " + QByteArray::number(soh) + "%\r\n";
+  text += "SOC = " + QByteArray::number(soc) + "%\r\n";
+  text += "EN = " + QByteArray::number(measured) + "CCA\r\n";
+  text += "RATED = " + QByteArray::number(rated) + "CCA\r\n";
+  text += "R = " + QByteArray::number(resistance, 'f', 2) + "m\x7F\r\n";
+  text += "VOLTAGE = " + QByteArray::number(voltage, 'f', 2) + "V\r\n";
+  text += soh >= 70 ? "GOOD BATTERY" : "REPLACE BATTERY";
+  return text;
+}
+
+QVector<ushort> sampleCrankingWaveform(qsizetype sampleCount, QRandomGenerator& rng) {
+  QVector<ushort> samples(sampleCount);
+  const qsizetype crankStart = sampleCount / 10, crankEnd = crankStart + sampleCount / 8;
+  const int resting = rng.bounded(120, 129), lowest = rng.bounded(85, 105), charging = rng.bounded(138, 146);
+
+  for (qsizetype i = 0; i < sampleCount; i++) {
+    int v = resting;
+    if (i >= crankEnd)
+      v = charging;
+    else if (i >= crankStart) // sharp drop that recovers slowly while the engine turns
+      v = lowest + static_cast<int>((resting - 10 - lowest) * (i - crankStart) / qMax(crankEnd - crankStart, qsizetype(1)));
+    samples[i] = static_cast<ushort>(v + rng.bounded(-2, 3));
+  }
+  return samples;
+}
+} // namespace PacketBuilder
@@ -0,0 +1,22 @@
+#ifndef PACKETBUILDER_H
+#define PACKETBUILDER_H
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QVector>
+
+// Builds packets in the same format as the tester sends them, see the packet format section of README.
+namespace PacketBuilder {
+constexpr qsizetype maxSamplesPerPacket = (0xFFFF - 10) / 2; // packet length is 16 bits and includes header, FCS and trailer
+
+QByteArray battInfo(const QByteArray& text); // text without the trailing \r\n, lines separated by \r\n
+QByteArray chart(const ushort* samples, qsizetype count);
+QByteArray chartDisplay();
+
+// Battery parameters as reported by KW650 in English, values are randomised a bit. 0x7F is the placeholder of the omega sign.
+QByteArray sampleBattInfoText(QRandomGenerator& rng);
+// Voltage during cranking, in 0.1 V units: resting voltage, a sharp drop when the starter engages, then the alternator kicks in.
+QVector<ushort> sampleCrankingWaveform(qsizetype sampleCount, QRandomGenerator& rng);
+} // namespace PacketBuilder
+
+#endif // PACKETBUILDER_H
@@ -0,0 +1,175 @@
+#include "TesterEmulator.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "PacketBuilder.h"
+
+TesterEmulator::TesterEmulator(const Config& config, QObject* parent) : QObject{parent}, cfg(config), rng(config.seed), bootloader(config.flashSize) {
+  connect(&generateTimer, &QTimer::timeout, this, &TesterEmulator::generateTests);
+  connect(&sendTimer, &QTimer::timeout, this, &TesterEmulator::sendData);
+  connect(&statisticsTimer, &QTimer::timeout, this, &TesterEmulator::printStatistics);
+  sendTimer.setTimerType(Qt::PreciseTimer);
+  generateTimer.setTimerType(Qt::PreciseTimer);
+  connect(&decoder, &FrameDecoder::firmwareFrameReceived, this, &TesterEmulator::onFirmwareFrameReceived);
+}
+
+TesterEmulator::~TesterEmulator() {
+  if (slaveFd >= 0)
+    ::close(slaveFd);
+  if (masterFd >= 0)
+    ::close(masterFd);
+}
+
+bool TesterEmulator::open() {
+  masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)) {
+    error = QString::fromLocal8Bit(strerror(errno));
+    return false;
+  }
+
+  slavePortName = QString::fromLocal8Bit(ptsname(masterFd));
+  slaveFd = ::open(ptsname(masterFd), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (slaveFd < 0) {
+    error = QString::fromLocal8Bit(strerror(errno));
+    return false;
+  }
+
+  termios tio; // binary data, no echo and no line editing, just like a real serial port
+  tcgetattr(slaveFd, &tio);
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B115200);
+  tcsetattr(slaveFd, TCSANOW, &tio);
+
+  readNotifier = new QSocketNotifier(masterFd, QSocketNotifier::Read, this);
+  connect(readNotifier, &QSocketNotifier::activated, this, &TesterEmulator::readData);
+  return true;
+}
+
+void TesterEmulator::start() {
+  clock.start();
+  sendTimer.start(1);
+  statisticsTimer.start(1000);
+  if (cfg.bootloader)
+    return; // waits for the host
+
+  generateTimer.start(qMax(1, qRound(1000.0 / cfg.testsPerSecond)));
+  generateTests(); // first test is sent right away
+}
+
+void TesterEmulator::generateTests() {
+  pending.remove(0, pendingPos); // drop the data that was already written, so the buffer doesn't grow when the reader is slow
+  pendingPos = 0;
+
+  for (int i = 0; i < cfg.burstSize; i++) {
+    if (cfg.testCount && testsGenerated >= cfg.testCount) {
+      generateTimer.stop();
+      return;
+    }
+
+    queuePacket(PacketBuilder::battInfo(PacketBuilder::sampleBattInfoText(rng)));
+    const QVector<ushort> samples = PacketBuilder::sampleCrankingWaveform(cfg.samplesPerTest, rng);
+    const qsizetype perPacket = qBound(qsizetype(1), cfg.samplesPerPacket, PacketBuilder::maxSamplesPerPacket);
+    for (qsizetype pos = 0; pos < samples.size(); pos += perPacket)
+      queuePacket(PacketBuilder::chart(samples.constData() + pos, qMin(perPacket, samples.size() - pos)));
+    queuePacket(PacketBuilder::chartDisplay());
+    testsGenerated++;
+  }
+}
+
+void TesterEmulator::queuePacket(QByteArray packet) {
+  if (cfg.garbageRate > 0.0 && rng.generateDouble() < cfg.garbageRate) {
+    const qsizetype garbageLen = rng.bounded(1, 64);
+    for (qsizetype i = 0; i < garbageLen; i++)
+      pending.append(static_cast<char>(rng.bounded(256)));
+  }
+  if (cfg.corruptionRate > 0.0 && rng.generateDouble() < cfg.corruptionRate)
+    packet[rng.bounded(static_cast<int>(packet.size()))] ^= static_cast<char>(1 << rng.bounded(8));
+  pending.append(packet);
+}
+
+void TesterEmulator::sendData() {
+  const qint64 now = clock.nsecsElapsed();
+  if (cfg.bytesPerSecond) { // the budget is capped, so a stalled reader doesn't cause a burst above the rate later
+    sendBudget = qMin(sendBudget + static_cast<double>(cfg.bytesPerSecond) * (now - lastSendNs) / 1e9, static_cast<double>(cfg.bytesPerSecond) / 10.0);
+  }
+  lastSendNs = now;
+
+  while (pendingPos < pending.size()) {
+    qsizetype len = pending.size() - pendingPos;
+    if (cfg.maxWriteSize)
+      len = qMin(len, static_cast<qsizetype>(rng.bounded(1, static_cast<int>(cfg.maxWriteSize) + 1)));
+    if (cfg.bytesPerSecond)
+      len = qMin(len, static_cast<qsizetype>(sendBudget));
+    if (len <= 0)
+      break;
+
+    const ssize_t written = ::write(masterFd, pending.constData() + pendingPos, len);
+    if (written <= 0)
+      break; // terminal buffer is full, the reader is slower than us
+    pendingPos += written;
+    bytesSent += written;
+    sendBudget -= written;
+  }
+
+  if (pendingPos == pending.size()) {
+    pending.resize(0); // keeps the capacity
+    pendingPos = 0;
+    if (cfg.testCount && testsGenerated >= cfg.testCount) {
+      sendTimer.stop();
+      printStatistics();
+      emit finished();
+    }
+  }
+}
+
+void TesterEmulator::readData() {
+  uchar buf[4096]; // tester ignores everything it receives, e.g. the heartbeat of the original software, the bootloader decodes it
+  ssize_t len;
+  while ((len = ::read(masterFd, buf, sizeof(buf))) > 0) {
+    bytesReceived += len;
+    if (!cfg.bootloader)
+      continue;
+    for (qsizetype fed = 0; fed < len;) { // the buffer is larger than the longest packet, so decoding always frees some space
+      fed += received.write(buf + fed, len - fed);
+      received.consume(decoder.decode(received.view()));
+    }
+  }
+}
+
+void TesterEmulator::onFirmwareFrameReceived(uchar type, const RingBuffer::View& payload) {
+  if (cfg.dropRate > 0.0 && rng.generateDouble() < cfg.dropRate) {
+    packetsDropped++;
+    return;
+  }
+
+  const QByteArray answer = bootloader.handlePacket(type, payload);
+  if (answer.isEmpty())
+    return;
+  queuePacket(answer);
+  if (type == uchar(FirmwareProtocol::Type::Finish) && bootloader.isImageComplete()) {
+    QTextStream(stdout) << "firmware image of " << bootloader.imageSize() << " B written" << Qt::endl;
+    QFile file(cfg.flashFileName);
+    if (!cfg.flashFileName.isEmpty() && (!file.open(QFile::WriteOnly) || file.write(bootloader.flash().constData(), bootloader.imageSize()) != bootloader.imageSize()))
+      QTextStream(stderr) << "Unable to save the firmware image: " << file.errorString() << Qt::endl;
+  }
+}
+
+void TesterEmulator::printStatistics() {
+  const qint64 now = clock.nsecsElapsed();
+  const double seconds = (now - lastReportNs) / 1e9;
+  QTextStream(stdout) << "tests: " << testsGenerated << ", sent: " << bytesSent << " B (" << QString::number((bytesSent - bytesSentReported) / qMax(seconds, 1e-9), 'f', 0)
+                      << " B/s), waiting: " << pending.size() - pendingPos << " B, received: " << bytesReceived << " B";
+  if (cfg.bootloader)
+    QTextStream(stdout) << ", firmware blocks written: " << bootloader.writtenBlocks() << ", packets dropped: " << packetsDropped;
+  QTextStream(stdout) << Qt::endl;
+  bytesSentReported = bytesSent;
+  lastReportNs = now;
+}
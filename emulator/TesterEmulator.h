@@ -0,0 +1,90 @@
+#ifndef TESTEREMULATOR_H
+#define TESTEREMULATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include "FirmwareBootloader.h"
+#include "FrameDecoder.h"
+#include "RingBuffer.h"
+
+// Behaves like a KW650/KW720 connected through a serial port: every test sends battery parameters (type 1 packet),
+// the voltage waveform split into chart packets and the chart display packet. Data goes to the master side of a pseudo-terminal,
+// KBTinfo opens its slave side like any other serial port. In the bootloader mode it sends no tests and only answers firmware updates.
+class TesterEmulator : public QObject {
+  Q_OBJECT
+public:
+  struct Config {
+    double testsPerSecond = 1.0;
+    int burstSize = 1;               // tests generated at once
+    qint64 bytesPerSecond = 11520;   // 0 means as fast as the reader takes the data, 11520 is the real 115200 baud rate
+    qsizetype maxWriteSize = 0;      // data is written in random chunks of up to that many bytes, 0 means whole packets
+    qsizetype samplesPerTest = 800;  // 10 s of samples
+    qsizetype samplesPerPacket = 256;
+    double corruptionRate = 0.0;     // probability of a flipped byte in a packet
+    double garbageRate = 0.0;        // probability of random bytes between packets
+    qint64 testCount = 0;            // 0 means no limit
+    quint32 seed = 1;
+    bool bootloader = false;
+    qsizetype flashSize = 4 * 1024 * 1024;
+    double dropRate = 0.0; // probability of a lost firmware packet from the host, as if it was damaged on the way
+    QString flashFileName; // written image is saved there after every successful update
+  };
+
+public:
+  explicit TesterEmulator(const Config& config, QObject* parent = nullptr);
+  ~TesterEmulator();
+
+public:
+  bool open();                                        // creates the pseudo-terminal and returns false if it can't be done
+  QString portName() const { return slavePortName; }  // path to give to KBTinfo
+  QString errorString() const { return error; }
+  void start();
+
+signals:
+  void finished();
+
+private slots:
+  void generateTests();
+  void sendData();
+  void readData();
+  void printStatistics();
+
+private:
+  void queuePacket(QByteArray packet);
+  void onFirmwareFrameReceived(uchar type, const RingBuffer::View& payload);
+
+private:
+  Config cfg;
+  QRandomGenerator rng;
+  int masterFd = -1;
+  int slaveFd = -1; // kept open, so the terminal settings survive the reader closing the port
+  QString slavePortName;
+  QString error;
+
+  QTimer generateTimer;
+  QTimer sendTimer;
+  QTimer statisticsTimer;
+  QSocketNotifier* readNotifier = nullptr;
+  QElapsedTimer clock;
+
+  QByteArray pending; // generated data that wasn't written yet
+  qsizetype pendingPos = 0;
+  double sendBudget = 0.0; // bytes that can be written now without exceeding the rate
+  qint64 lastSendNs = 0;
+
+  qint64 testsGenerated = 0;
+  quint64 bytesSent = 0, bytesSentReported = 0;
+  quint64 bytesReceived = 0;
+
+  RingBuffer received{128 * 1024}; // data from the host, decoded only in the bootloader mode
+  FrameDecoder decoder;
+  FirmwareBootloader bootloader;
+  quint64 packetsDropped = 0;
+  qint64 lastReportNs = 0;
+};
+
+#endif // TESTEREMULATOR_H
@@ -0,0 +1,60 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+#include "TesterEmulator.h"
+
+int main(int argc, char* argv[]) {
+  QCoreApplication a(argc, argv);
+  QCoreApplication::setApplicationName("kbtinfo-emu");
+  QCoreApplication::setApplicationVersion("v1.0.0.0");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Emulates a Konnwei battery tester on a pseudo-terminal. Open the printed port in KBTinfo.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  const QCommandLineOption rateOption("rate", "Tests per second.", "tests", "1");
+  const QCommandLineOption burstOption("burst", "Tests generated at once.", "tests", "1");
+  const QCommandLineOption bpsOption("bps", "Output rate in bytes per second, 0 for unlimited.", "bytes", "11520");
+  const QCommandLineOption splitOption("split", "Write the data in random chunks of up to this many bytes, 0 writes whole packets.", "bytes", "0");
+  const QCommandLineOption samplesOption("samples", "Waveform samples per test.", "count", "800");
+  const QCommandLineOption packetSamplesOption("packet-samples", "Waveform samples per chart packet.", "count", "256");
+  const QCommandLineOption corruptOption("corrupt", "Probability of a damaged packet.", "probability", "0");
+  const QCommandLineOption garbageOption("garbage", "Probability of random bytes between packets.", "probability", "0");
+  const QCommandLineOption countOption("count", "Number of tests to send, 0 for no limit.", "tests", "0");
+  const QCommandLineOption seedOption("seed", "Seed of the random data.", "seed", "1");
+  const QCommandLineOption bootloaderOption("bootloader", "Send no tests, answer firmware updates instead.");
+  const QCommandLineOption flashSizeOption("flash-size", "Size of the emulated flash in bytes.", "bytes", "4194304");
+  const QCommandLineOption dropOption("drop", "Probability of a lost firmware packet from KBTinfo.", "probability", "0");
+  const QCommandLineOption flashFileOption("flash-file", "Save every successfully written firmware image to this file.", "file");
+  parser.addOptions({rateOption, burstOption, bpsOption, splitOption, samplesOption, packetSamplesOption, corruptOption, garbageOption, countOption, seedOption,
+                     bootloaderOption, flashSizeOption, dropOption, flashFileOption});
+  parser.process(a);
+
+  TesterEmulator::Config cfg;
+  cfg.testsPerSecond = qMax(parser.value(rateOption).toDouble(), 0.001);
+  cfg.burstSize = qMax(parser.value(burstOption).toInt(), 1);
+  cfg.bytesPerSecond = qMax(parser.value(bpsOption).toLongLong(), qint64(0));
+  cfg.maxWriteSize = qMax(parser.value(splitOption).toLongLong(), qint64(0));
+  cfg.samplesPerTest = qMax(parser.value(samplesOption).toLongLong(), qint64(1));
+  cfg.samplesPerPacket = qMax(parser.value(packetSamplesOption).toLongLong(), qint64(1));
+  cfg.corruptionRate = parser.value(corruptOption).toDouble();
+  cfg.garbageRate = parser.value(garbageOption).toDouble();
+  cfg.testCount = qMax(parser.value(countOption).toLongLong(), qint64(0));
+  cfg.seed = parser.value(seedOption).toUInt();
+  cfg.bootloader = parser.isSet(bootloaderOption);
+  cfg.flashSize = qMax(parser.value(flashSizeOption).toLongLong(), qint64(1));
+  cfg.dropRate = parser.value(dropOption).toDouble();
+  cfg.flashFileName = parser.value(flashFileOption);
+
+  TesterEmulator emulator(cfg);
+  if (!emulator.open()) {
+    QTextStream(stderr) << "Unable to create a pseudo-terminal: " << emulator.errorString() << Qt::endl;
+    return 1;
+  }
+
+  QTextStream(stdout) << "Emulated tester is available at " << emulator.portName() << Qt::endl;
+  QObject::connect(&emulator, &TesterEmulator::finished, &a, &QCoreApplication::quit);
+  emulator.start();
+  return a.exec();
+}
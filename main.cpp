@@ -1,6 +1,8 @@
 #include "MainWindow.h"
+#include "Trace.h"
 
 #include <QApplication>
+#include <QFile>
 #include <QLocale>
 #include <QTranslator>
 
@@ -21,8 +23,24 @@ int main(int argc, char* argv[]) {
       break;
     }
   }
-  MainWindow w;
-  w.setWindowTitle(w.windowTitle() + ' ' + QCoreApplication::applicationVersion());
-  w.show();
-  return a.exec();
+
+  const QString traceFileName = qEnvironmentVariable("KBTINFO_TRACE"); // Chrome trace of the whole run is written there on exit
+  if (!traceFileName.isEmpty())
+    Trace::start();
+
+  int res;
+  { // the window and its worker threads are gone before the trace is written, so nothing records into the buffers being read
+    MainWindow w;
+    w.setWindowTitle(w.windowTitle() + ' ' + QCoreApplication::applicationVersion());
+    w.show();
+    res = a.exec();
+  }
+
+  if (!traceFileName.isEmpty()) {
+    Trace::stop();
+    QFile traceFile(traceFileName);
+    if (!traceFile.open(QFile::WriteOnly) || !Trace::writeJson(traceFile))
+      qWarning("Unable to write the trace to %s", qPrintable(traceFileName));
+  }
+  return res;
 }